@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <functional>
+#include <stdexcept>
+
+#include "core/Simulation.hpp"
+#include "core/TaskControl.hpp"
+#include "api/ScenarioGenerator.hpp"
+#include "shared/simulation_structures.hpp"
+/**
+ * @file BatchRunner.hpp
+ * @brief Contains the BatchRunner class running many simulations of random deployments in parallel.
+ */
+
+/**
+ * @struct BatchSpec
+ * @brief Describes a batch of simulations that differ only in their randomly generated scenario.
+ */
+struct BatchSpec
+{
+  SimulationParameters parameters;                     ///< The parameters shared by all runs.
+  uint32_t target_num = 0;                             ///< The number of targets of every scenario.
+  uint32_t sensor_num = 0;                             ///< The number of sensors of every scenario.
+  ScenarioGeneratorOptions generator;                  ///< The generator of scenarios. Run k uses seed generator.seed + k.
+  SpatialOrdering ordering = SpatialOrdering::kInput;  ///< The order in which every simulation stores sensors and targets.
+  uint32_t run_num = 1;                                ///< The number of runs.
+  std::vector<float> percentiles = {0.1f, 0.5f, 0.9f}; ///< The percentiles of lifetime and coverage to report, between 0 and 1.
+  uint32_t thread_num = 0;                             ///< The number of threads, or 0 for all hardware threads.
+};
+
+/**
+ * @struct BatchRunSummary
+ * @brief The outcome of a single run of a batch.
+ */
+struct BatchRunSummary
+{
+  uint32_t run = 0;             ///< The index of the run in the batch.
+  uint64_t seed = 0;            ///< The seed its scenario was generated with.
+  bool failed = false;          ///< Indicates if generating or initializing the scenario failed. Failed runs are left out of the statistics.
+  std::string error;            ///< The reason of the failure, empty otherwise.
+  uint32_t lifetime = 0;        ///< The tick of the last state, as reported by the simulation when it stopped.
+  float initial_coverage = 0.f; ///< The coverage percentage of the first state.
+  float final_coverage = 0.f;   ///< The coverage percentage of the last state.
+};
+
+/**
+ * @struct BatchStatistics
+ * @brief Aggregate results of a batch.
+ * @details Coverage statistics are computed per tick over all successful runs. A run that has already stopped counts as
+ * uncovered, so the curves describe the share of deployments still providing coverage. Percentiles are nearest-rank;
+ * coverage is binned to steps of 1 / kCoverageBins before ranking.
+ */
+struct BatchStatistics
+{
+  static constexpr uint32_t kCoverageBins = 1000; ///< The resolution of coverage percentiles.
+
+  uint32_t run_num = 0;                                 ///< The number of successful runs.
+  uint32_t failed_run_num = 0;                          ///< The number of failed runs.
+  double lifetime_mean = 0.0;                           ///< The mean lifetime.
+  double lifetime_stddev = 0.0;                         ///< The standard deviation of the lifetime.
+  uint32_t lifetime_min = 0;                            ///< The shortest lifetime.
+  uint32_t lifetime_max = 0;                            ///< The longest lifetime.
+  std::vector<uint32_t> lifetime_percentiles;           ///< The lifetime at each of BatchSpec::percentiles.
+  std::vector<float> coverage_mean;                     ///< The mean coverage percentage at every tick.
+  std::vector<std::vector<float>> coverage_percentiles; ///< For each of BatchSpec::percentiles, the coverage percentage at every tick.
+};
+
+/**
+ * @class BatchRunner
+ * @brief Runs a batch of simulations of random deployments across all cores.
+ * @details Each run generates its scenario, initializes a Simulation and advances it until the stop condition
+ * or max ticks, all on one worker of a work-stealing ThreadPool. Only counters and histograms indexed by tick
+ * are kept across runs, so memory does not grow with the number of runs; per-run summaries are streamed to a callback.
+ * The statistics depend only on the spec, not on the number of threads or the order in which runs finish.
+ */
+class BatchRunner
+{
+  BatchSpec spec_; ///< The batch to run.
+
+public:
+  /**
+   * @brief Constructs the runner.
+   * @param spec The batch to run.
+   * @throws std::runtime_error if the parameters, counts or percentiles are invalid.
+   */
+  explicit BatchRunner(BatchSpec spec);
+  const BatchSpec &GetSpec() const { return spec_; } ///< Gets the batch to run.
+  /**
+   * @brief Runs the batch.
+   * @param on_run Optional function receiving the summary of every run as soon as it finishes, in order of completion.
+   * Calls are never concurrent. It may be a Python callable.
+   * @param control Optional progress and cancellation flag. Progress is the fraction of finished runs.
+   * @return The statistics of all successful runs.
+   * @throws std::runtime_error on cancellation; rethrows exceptions of on_run.
+   */
+  BatchStatistics Run(const std::function<void(const BatchRunSummary &)> &on_run = {}, TaskControl *control = nullptr) const;
+};
@@ -0,0 +1,181 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+
+#include "shared/simulation_structures.hpp"
+#include "api/StateSink.hpp"
+#include "api/MappedFile.hpp"
+/**
+ * @file BinaryHistory.hpp
+ * @brief Contains the writer and reader of the binary columnar history format.
+ * @details A file starts with a 64 byte BinaryHistoryHeader, followed by blocks of equal size.
+ * Every block holds block_ticks consecutive states as columns, each column starting at a multiple of 8 bytes:
+ * - tick: uint32[block_ticks]
+ * - covered_target_count: uint32[block_ticks]
+ * - coverage_percentage: float32[block_ticks]
+ * - sensor_states: uint8[block_ticks][sensor_num], values of Sensor::State
+ * - sensor_battery_lvls: int32[block_ticks][sensor_num]
+ * - is_target_covered: uint64[block_ticks][ceil(target_num / 64)], bit t % 64 of word t / 64 is target t
+ * The last block is padded to full size, only the first tick_count states of the file are valid.
+ * All values are little-endian, so the file can also be read directly, e.g. with numpy.memmap.
+ */
+
+/**
+ * @struct BinaryHistoryHeader
+ * @brief Header of a binary history file.
+ */
+struct BinaryHistoryHeader
+{
+  static constexpr char kMagic[8] = "WSNHIST"; ///< Expected value of magic.
+  static constexpr uint32_t kVersion = 1;      ///< Current version of the format.
+
+  char magic[8];        ///< Identifies the format, equal to kMagic.
+  uint32_t version;     ///< Version of the format.
+  uint32_t block_ticks; ///< Number of states in a block.
+  uint64_t sensor_num;  ///< Number of sensors in every state.
+  uint64_t target_num;  ///< Number of targets in every state.
+  uint64_t tick_count;  ///< Number of states in the file.
+  uint64_t reserved[3]; ///< Unused, zero.
+};
+static_assert(sizeof(BinaryHistoryHeader) == 64, "BinaryHistoryHeader must be 64 bytes");
+
+/**
+ * @struct BinaryHistoryLayout
+ * @brief Offsets of columns within a block, derived from the header.
+ */
+struct BinaryHistoryLayout
+{
+  size_t block_ticks = 0;       ///< Number of states in a block.
+  size_t sensor_num = 0;        ///< Number of sensors in every state.
+  size_t coverage_words = 0;    ///< Number of 64-bit words of the coverage bitmap of a state.
+  size_t tick_offset = 0;       ///< Offset of the tick column.
+  size_t covered_offset = 0;    ///< Offset of the covered_target_count column.
+  size_t percentage_offset = 0; ///< Offset of the coverage_percentage column.
+  size_t state_offset = 0;      ///< Offset of the sensor_states column.
+  size_t battery_offset = 0;    ///< Offset of the sensor_battery_lvls column.
+  size_t coverage_offset = 0;   ///< Offset of the is_target_covered column.
+  size_t block_size = 0;        ///< Size of a block in bytes.
+
+  BinaryHistoryLayout() = default;
+  /**
+   * @brief Computes the layout of blocks described by a header.
+   * @param header The header of the file.
+   */
+  explicit BinaryHistoryLayout(const BinaryHistoryHeader &header);
+  /**
+   * @brief Gets the file offset of a block.
+   * @param block The index of the block.
+   * @return The offset in bytes.
+   */
+  size_t BlockOffset(size_t block) const { return sizeof(BinaryHistoryHeader) + block * block_size; }
+};
+
+/**
+ * @class BinaryStateSink
+ * @brief Writes states to a file in the binary columnar history format as they are produced.
+ * @details Only the current block is kept in memory. Flush writes the partially filled block and the state count,
+ * so the file is readable after every run, and later states continue the same block.
+ */
+class BinaryStateSink : public StateSink
+{
+  std::ofstream file_;         ///< The output file.
+  BinaryHistoryHeader header_; ///< Header of the file, updated on Flush.
+  BinaryHistoryLayout layout_; ///< Layout of blocks, known after the first state.
+  std::vector<uint8_t> block_; ///< The block being filled.
+  size_t block_index_ = 0;     ///< Index of the block being filled.
+  size_t block_fill_ = 0;      ///< Number of states in the block being filled.
+
+public:
+  /**
+   * @brief Opens the output file, replacing its content.
+   * @param path The path to the output file.
+   * @param block_ticks Number of states in a block, or 0 to choose blocks of at most 256 states and about 4 MiB.
+   * @exception Throws std::runtime_error if the file cannot be opened.
+   */
+  explicit BinaryStateSink(const std::string &path, uint32_t block_ticks = 0);
+  /**
+   * @brief Flushes the remaining states.
+   */
+  ~BinaryStateSink() override;
+  /**
+   * @brief Appends a state to the file.
+   * @param state The state to append.
+   * @exception Throws std::runtime_error if the number of sensors or targets differs from the previous states.
+   */
+  void Append(const SimulationState &state);
+  void Push(SimulationState &&state) override { Append(state); } ///< Appends a state to the file.
+  void Flush() override;
+
+private:
+  void WriteBlock(); ///< Writes the block being filled at its place in the file.
+};
+
+/**
+ * @class BinaryHistoryReader
+ * @brief Random access to the states of a binary history file.
+ * @details The file is memory mapped, so only the blocks of the requested states are read from disk.
+ */
+class BinaryHistoryReader
+{
+  MappedFile file_;            ///< The mapped file.
+  BinaryHistoryHeader header_; ///< Header of the file.
+  BinaryHistoryLayout layout_; ///< Layout of blocks.
+
+public:
+  /**
+   * @brief Opens a binary history file.
+   * @param path The path to the file.
+   * @exception Throws std::runtime_error if the file cannot be mapped or is not a valid binary history.
+   */
+  explicit BinaryHistoryReader(const std::string &path);
+  size_t GetTickCount() const { return header_.tick_count; } ///< Gets the number of states in the file.
+  size_t GetSensorNum() const { return header_.sensor_num; } ///< Gets the number of sensors in every state.
+  size_t GetTargetNum() const { return header_.target_num; } ///< Gets the number of targets in every state.
+  /**
+   * @brief Gets the tick of a state without decoding it.
+   * @param index The index of the state in the file.
+   * @return The tick of the state.
+   * @exception Throws std::out_of_range if the index is out of range.
+   */
+  uint32_t GetTick(size_t index) const;
+  /**
+   * @brief Decodes a state.
+   * @param index The index of the state in the file.
+   * @return The state.
+   * @exception Throws std::out_of_range if the index is out of range.
+   */
+  SimulationState GetState(size_t index) const;
+  /**
+   * @brief Decodes the state of a given tick.
+   * @param tick The tick of the state.
+   * @return The state.
+   * @exception Throws std::runtime_error if the file has no state at the tick.
+   */
+  SimulationState GetStateAt(uint32_t tick) const;
+
+private:
+  /**
+   * @brief Checks that a state is stored at an index.
+   * @param index The index of the state in the file.
+   * @exception Throws std::out_of_range if the index is not below the tick count.
+   */
+  void CheckIndex(size_t index) const;
+  /**
+   * @brief Reads a value of a column.
+   * @param column_offset The offset of the column within a block.
+   * @param index The index of the state in the file.
+   * @return The value of the state.
+   */
+  template <typename T>
+  T ReadValue(size_t column_offset, size_t index) const
+  {
+    T value;
+    const uint8_t *row = file_.Data() + layout_.BlockOffset(index / layout_.block_ticks) + column_offset + (index % layout_.block_ticks) * sizeof(T);
+    std::memcpy(&value, row, sizeof(T));
+    return value;
+  }
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+#include "core/Simulation.hpp"
+#include "shared/simulation_structures.hpp"
+#include "api/MappedFile.hpp"
+/**
+ * @file Checkpoint.hpp
+ * @brief Contains the reader and writer of checkpoints, binary files from which a running simulation is restored.
+ * @details A checkpoint is split in two files:
+ * - the layout file holds what Initialize derives from the scenario: positions, orderings, neighborhoods and covers.
+ *   It is named after its content hash, which covers the body and the sensor radius and counts of the header,
+ *   so all checkpoints of runs of one initialized scenario share it.
+ * - the checkpoint file holds the parameters and the mutable runtime (SimulationSnapshot) and refers to
+ *   its layout file by hash. It is small, so it can be written often.
+ *
+ * After the header, both files are sequences of arrays. Every array is a uint64 element count followed by the
+ * elements, padded to a multiple of 8 bytes. Covers are stored as their packed 16-byte records, LDGraph edges as one array per field.
+ * Files are read through a memory mapping and arrays are copied out in bulk, without any parsing.
+ * All values are little-endian.
+ */
+
+/**
+ * @struct LayoutFileHeader
+ * @brief Header of a layout file.
+ */
+struct LayoutFileHeader
+{
+  static constexpr char kMagic[8] = "WSNLAYT"; ///< Expected value of magic.
+  static constexpr uint32_t kVersion = 3;      ///< Current version of the format.
+
+  char magic[8];         ///< Identifies the format, equal to kMagic.
+  uint32_t version;      ///< Version of the format.
+  uint32_t reserved;     ///< Unused, zero.
+  uint64_t content_hash; ///< Hash of everything following the header, then of sensor_radius and the counts.
+  double sensor_radius;  ///< The sensing radius the covers were generated for.
+  uint64_t target_num;   ///< Number of targets.
+  uint64_t sensor_num;   ///< Number of sensors.
+  uint64_t cover_num;    ///< Number of covers of all sensors.
+  uint64_t reserved2;    ///< Unused, zero.
+};
+static_assert(sizeof(LayoutFileHeader) == 64, "LayoutFileHeader must be 64 bytes");
+
+/**
+ * @struct CheckpointHeader
+ * @brief Header of a checkpoint file.
+ */
+struct CheckpointHeader
+{
+  static constexpr char kMagic[8] = "WSNCKPT"; ///< Expected value of magic.
+  static constexpr uint32_t kVersion = 3;      ///< Current version of the format.
+
+  char magic[8];                ///< Identifies the format, equal to kMagic.
+  uint32_t version;             ///< Version of the format.
+  uint32_t spatial_ordering;    ///< Value of SpatialOrdering used for initialization.
+  uint64_t layout_hash;         ///< Content hash of the layout file.
+  uint64_t content_hash;        ///< Hash of everything following the header.
+  double sensor_radius;         ///< Value of SimulationParameters::sensor_radius.
+  uint32_t initial_battery_lvl; ///< Value of SimulationParameters::initial_battery_lvl.
+  uint32_t reshuffle_interval;  ///< Value of SimulationParameters::reshuffle_interval.
+  uint32_t max_ticks;           ///< Value of SimulationParameters::max_ticks.
+  uint32_t stop_condition;      ///< Value of SimulationParameters::stop_condition.
+  float stop_threshold;         ///< Value of SimulationParameters::stop_threshold.
+  uint32_t ticks_run;           ///< Number of ticks run since initialization.
+  uint32_t tick;                ///< The last tick of the simulation.
+  uint32_t finished;            ///< 1 if the simulation reached max ticks or its stop condition, 0 otherwise.
+};
+static_assert(sizeof(CheckpointHeader) == 72, "CheckpointHeader must be 72 bytes");
+
+/**
+ * @struct Checkpoint
+ * @brief Content of a checkpoint file.
+ */
+struct Checkpoint
+{
+  uint64_t layout_hash = 0;                           ///< Content hash of the layout file.
+  SimulationParameters parameters;                    ///< The parameters of the simulation.
+  SpatialOrdering ordering = SpatialOrdering::kInput; ///< The ordering used for initialization.
+  uint32_t ticks_run = 0;                             ///< Number of ticks run since initialization.
+  bool finished = false;                              ///< Indicates if the simulation reached max ticks or its stop condition.
+  SimulationSnapshot snapshot;                        ///< The mutable runtime of the simulation.
+};
+
+/**
+ * @brief Computes the content hash of a layout, equal to the one WriteLayoutFile records.
+ * @param scenario The scenario the layout was computed for.
+ * @param layout The layout.
+ * @return The hash.
+ */
+uint64_t HashLayout(ScenarioView scenario, const SimulationLayout &layout);
+
+/**
+ * @brief Gets the path of the layout file a checkpoint refers to.
+ * @param checkpoint_path The path to the checkpoint file.
+ * @param layout_hash The content hash of the layout.
+ * @return A file in the directory of the checkpoint, named after the hash.
+ */
+std::string LayoutFilePath(const std::string &checkpoint_path, uint64_t layout_hash);
+
+/**
+ * @brief Writes a layout file, replacing its content.
+ * @details The file is written under a temporary name and renamed when complete,
+ * so a crash never leaves a partial file behind.
+ * @param path The path to the output file.
+ * @param scenario The scenario the layout was computed for.
+ * @param layout The layout.
+ * @exception Throws std::runtime_error if the file cannot be written.
+ */
+void WriteLayoutFile(const std::string &path, ScenarioView scenario, const SimulationLayout &layout);
+
+/**
+ * @brief Reads a layout file.
+ * @param path The path to the file.
+ * @param layout_hash The expected content hash.
+ * @param scenario Receives the scenario.
+ * @param layout Receives the layout.
+ * @exception Throws std::runtime_error if the file cannot be read, is not a valid layout file or its content
+ * does not match the hash.
+ */
+void ReadLayoutFile(const std::string &path, uint64_t layout_hash, SimulationScenario &scenario, SimulationLayout &layout);
+
+/**
+ * @brief Writes a checkpoint file, replacing its content.
+ * @details The file is written under a temporary name and renamed when complete,
+ * so the previous checkpoint survives a crash during the write.
+ * @param path The path to the output file.
+ * @param checkpoint The checkpoint.
+ * @exception Throws std::runtime_error if the file cannot be written.
+ */
+void WriteCheckpoint(const std::string &path, const Checkpoint &checkpoint);
+
+/**
+ * @brief Reads a checkpoint file.
+ * @param path The path to the file.
+ * @return The checkpoint.
+ * @exception Throws std::runtime_error if the file cannot be read, is not a valid checkpoint or is corrupted.
+ */
+Checkpoint ReadCheckpoint(const std::string &path);
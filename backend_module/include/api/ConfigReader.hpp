@@ -0,0 +1,46 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <stdexcept>
+
+#include "shared/simulation_structures.hpp"
+/**
+ * @file ConfigReader.hpp
+ * @brief Contains functions reading simulation configs from files.
+ */
+
+/**
+ * @struct SimulationConfig
+ * @brief Parameters and scenario read from a config file. Either may be missing from the file.
+ */
+struct SimulationConfig
+{
+  std::optional<SimulationParameters> parameters; ///< The "parameters" object of the file, if present.
+  std::optional<SimulationScenario> scenario;     ///< The "scenario" object of the file, if present.
+};
+
+/**
+ * @brief Reads a JSON config file in a single pass.
+ * @details The file is memory mapped and parsed with a SAX handler: point coordinates go straight into
+ * the position vectors of the scenario, so no DOM of the (possibly huge) scenario is ever built.
+ * Only the small "parameters" object is collected as JSON and converted as before.
+ * @param json_path The path to the JSON file.
+ * @param read_parameters Whether to convert the "parameters" object.
+ * @param read_scenario Whether to collect the "scenario" object.
+ * @return The config read from the file.
+ * @throws std::runtime_error if the file cannot be opened or parsed, or its content has an unexpected structure.
+ */
+SimulationConfig ReadConfigJSON(const std::string &json_path, bool read_parameters = true, bool read_scenario = true);
+
+/**
+ * @brief Reads a scenario from a CSV file, parsing chunks of the file in parallel.
+ * @details Every line holds one position as `kind,x,y`, where kind is `target` or `sensor`, e.g. `sensor,0.25,0.5`.
+ * Positions of each kind keep the order of the file. Empty lines and lines starting with '#' are skipped,
+ * and so is the first line if it is not a position, e.g. a `kind,x,y` header.
+ * The file is memory mapped and split at line breaks. Lines of each chunk are counted first, then every chunk
+ * parses its numbers with std::from_chars straight into its slice of the position vectors.
+ * @param csv_path The path to the CSV file.
+ * @return The scenario read from the file.
+ * @throws std::runtime_error if the file cannot be opened or a line is not a valid position.
+ */
+SimulationScenario ReadScenarioCSV(const std::string &csv_path);
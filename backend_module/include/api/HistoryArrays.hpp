@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+
+#include "shared/simulation_structures.hpp"
+/**
+ * @file HistoryArrays.hpp
+ * @brief Contains the HistoryArrays class that stores simulation states as dense row-major arrays.
+ */
+
+/**
+ * @class HistoryArrays
+ * @brief Simulation states laid out as contiguous arrays, one row per state.
+ * @details Per-sensor and per-target values form tick_count x sensor_num and tick_count x target_num matrices,
+ * summary values form arrays of length tick_count. The arrays can be shared with NumPy without copying.
+ * Sensor states are stored as the underlying values of Sensor::State, coverage as 0 or 1.
+ * Once shared, the arrays must not grow, since appending may move them; SimulationManager therefore builds
+ * a new instance whenever its history grows.
+ * @note Memory grows with ticks times sensors, so for long runs of large networks prefer SimulationHistory.
+ */
+class HistoryArrays
+{
+  size_t sensor_num_ = 0;                       ///< Number of sensors in every state.
+  size_t target_num_ = 0;                       ///< Number of targets in every state.
+  std::vector<uint32_t> ticks_;                 ///< Tick of every state.
+  std::vector<uint32_t> covered_target_counts_; ///< Count of covered targets in every state.
+  std::vector<float> coverage_percentages_;     ///< Fraction of covered targets in every state.
+  std::vector<uint8_t> sensor_states_;          ///< States of sensors, row per state.
+  std::vector<int32_t> sensor_battery_lvls_;    ///< Battery levels of sensors, row per state.
+  std::vector<uint8_t> is_target_covered_;      ///< Coverage of targets, row per state.
+
+public:
+  /**
+   * @brief Appends a state as a new row.
+   * @param state The state to append.
+   * @exception Throws std::runtime_error if the number of sensors or targets differs from the previous states.
+   */
+  void Append(const SimulationState &state);
+  /**
+   * @brief Reserves memory for a number of states.
+   * @param tick_count The expected number of states.
+   * @param sensor_num The number of sensors in every state.
+   * @param target_num The number of targets in every state.
+   */
+  void Reserve(size_t tick_count, size_t sensor_num, size_t target_num);
+  size_t GetTickCount() const { return ticks_.size(); }                                          ///< Gets the number of stored states (rows).
+  size_t GetSensorNum() const { return sensor_num_; }                                            ///< Gets the number of sensors (columns of per-sensor arrays).
+  size_t GetTargetNum() const { return target_num_; }                                            ///< Gets the number of targets (columns of per-target arrays).
+  const std::vector<uint32_t> &GetTicks() const { return ticks_; }                               ///< Gets the tick of every state.
+  const std::vector<uint32_t> &GetCoveredTargetCounts() const { return covered_target_counts_; } ///< Gets the count of covered targets in every state.
+  const std::vector<float> &GetCoveragePercentages() const { return coverage_percentages_; }     ///< Gets the fraction of covered targets in every state.
+  const std::vector<uint8_t> &GetSensorStates() const { return sensor_states_; }                 ///< Gets the states of sensors, row-major.
+  const std::vector<int32_t> &GetSensorBatteryLvls() const { return sensor_battery_lvls_; }      ///< Gets the battery levels of sensors, row-major.
+  const std::vector<uint8_t> &GetIsTargetCovered() const { return is_target_covered_; }          ///< Gets the coverage of targets, row-major.
+};
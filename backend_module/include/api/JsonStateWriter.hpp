@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <ostream>
+
+#include "shared/simulation_structures.hpp"
+/**
+ * @file JsonStateWriter.hpp
+ * @brief Contains the JsonStateWriter class that writes simulation states as JSON without building a DOM.
+ */
+
+/**
+ * @class JsonStateWriter
+ * @brief Streams a JSON array of simulation states to an output stream.
+ * @details Text is formatted into an internal buffer that is handed to the stream in large chunks.
+ * The output is identical to nlohmann::json(states).dump(indent): keys in alphabetical order,
+ * sensor states as their names and floats formatted like nlohmann, so existing consumers keep working.
+ * Integers are formatted with std::to_chars. Floats use the dtoa of nlohmann, since the shortest
+ * representation of std::to_chars differs from it for a small fraction of values.
+ */
+class JsonStateWriter
+{
+  std::ostream &out_;      ///< The output stream.
+  int indent_;             ///< Number of spaces per indentation level, or -1 for compact output.
+  std::string buffer_;     ///< Text not yet handed to the stream.
+  size_t state_count_ = 0; ///< Number of states written so far.
+
+public:
+  /**
+   * @brief Constructs a writer.
+   * @param out The output stream. It must outlive the writer.
+   * @param indent Number of spaces per indentation level, or -1 for compact output.
+   */
+  explicit JsonStateWriter(std::ostream &out, int indent = -1) : out_(out), indent_(indent) {}
+  /**
+   * @brief Writes a state as the next element of the array.
+   * @param state The state to write.
+   */
+  void Write(const SimulationState &state);
+  /**
+   * @brief Writes the end of the array and hands all text to the stream.
+   * @return The number of characters of the closing text, so that it can be overwritten when more states follow.
+   */
+  size_t Close();
+  /**
+   * @brief Hands the buffered text to the stream.
+   */
+  void Flush();
+  size_t GetStateCount() const { return state_count_; } ///< Gets the number of states written so far.
+  /**
+   * @brief Appends the JSON of a single state to a string.
+   * @param out The string to append to.
+   * @param state The state to format.
+   * @param indent Number of spaces per indentation level, or -1 for compact output.
+   * @param level Indentation level of the line holding the opening brace.
+   */
+  static void AppendState(std::string &out, const SimulationState &state, int indent = -1, int level = 0);
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+/**
+ * @file MappedFile.hpp
+ * @brief Contains the MappedFile class that maps a file into memory for reading.
+ */
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file.
+ * @details Uses mmap on POSIX systems and file mappings on Windows. Pages are loaded lazily by the OS,
+ * so opening a large file is cheap and only the accessed parts are read from disk.
+ */
+class MappedFile
+{
+  const uint8_t *data_ = nullptr; ///< Start of the mapped file, null for an empty file.
+  size_t size_ = 0;               ///< Size of the file in bytes.
+#ifdef _WIN32
+  void *mapping_ = nullptr; ///< Handle of the file mapping object.
+#endif
+
+public:
+  /**
+   * @brief Maps a file.
+   * @param path The path to the file.
+   * @exception Throws std::runtime_error if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  const uint8_t *Data() const { return data_; } ///< Gets the start of the mapped file.
+  size_t Size() const { return size_; }         ///< Gets the size of the file in bytes.
+};
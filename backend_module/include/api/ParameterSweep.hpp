@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "core/Simulation.hpp"
+#include "core/TaskControl.hpp"
+#include "shared/simulation_structures.hpp"
+/**
+ * @file ParameterSweep.hpp
+ * @brief Contains the ParameterSweep class running one scenario under many parameter variants.
+ */
+
+/**
+ * @struct SweepGrid
+ * @brief Values of every parameter; the variants of a sweep are all their combinations.
+ */
+struct SweepGrid
+{
+  std::vector<double> sensor_radii;                     ///< Values of SimulationParameters::sensor_radius.
+  std::vector<uint32_t> initial_battery_lvls;           ///< Values of SimulationParameters::initial_battery_lvl.
+  std::vector<uint32_t> reshuffle_intervals;            ///< Values of SimulationParameters::reshuffle_interval.
+  std::vector<uint32_t> max_ticks;                      ///< Values of SimulationParameters::max_ticks.
+  std::vector<SimulationStopCondition> stop_conditions; ///< Values of SimulationParameters::stop_condition.
+  std::vector<float> stop_thresholds = {0.0f};          ///< Values of SimulationParameters::stop_threshold.
+};
+
+/**
+ * @brief Lists all combinations of the values of a grid.
+ * @details The sensor radius varies slowest and the stop threshold fastest.
+ * @param grid The values of every parameter.
+ * @return The parameters of every combination.
+ * @throws std::runtime_error if any list of values is empty.
+ */
+std::vector<SimulationParameters> ExpandSweepGrid(const SweepGrid &grid);
+
+/**
+ * @struct SweepResult
+ * @brief A row of the result table of a sweep.
+ */
+struct SweepResult
+{
+  uint32_t variant = 0;                             ///< The index of the variant.
+  SimulationParameters parameters;                  ///< The parameters of the variant.
+  bool failed = false;                              ///< Indicates if initialization failed for the sensor radius of the variant.
+  std::string error;                                ///< The reason of the failure, empty otherwise.
+  uint32_t lifetime = 0;                            ///< The tick of the last state, as reported by the simulation when it stopped.
+  float initial_coverage = 0.f;                     ///< The coverage percentage of the first state.
+  float final_coverage = 0.f;                       ///< The coverage percentage of the last state.
+  float min_coverage = 0.f;                         ///< The lowest coverage percentage of any state.
+  uint32_t first_death_tick = RunSummary::kNoDeath; ///< The first tick at which a sensor ran out of battery, or RunSummary::kNoDeath.
+};
+
+/**
+ * @class ParameterSweep
+ * @brief Runs a single scenario under many parameter variants in parallel.
+ * @details Covers depend only on the positions and the sensor radius, so the scenario is initialized once per
+ * distinct radius, on the calling thread with all cores. Every variant then runs on a fork of that simulation
+ * (see Simulation::Fork) on a worker of a ThreadPool, while the next radius is initialized.
+ * Forks share the cover storage of their template and copy only its runtime arrays.
+ */
+class ParameterSweep
+{
+  SimulationScenario scenario_;                ///< The scenario shared by all variants.
+  std::vector<SimulationParameters> variants_; ///< The parameters of every variant.
+  SpatialOrdering ordering_;                   ///< The order in which simulations store sensors and targets.
+  uint32_t thread_num_;                        ///< The number of threads running variants, or 0 for all hardware threads.
+
+public:
+  /**
+   * @brief Constructs the sweep.
+   * @param scenario The scenario shared by all variants.
+   * @param variants The parameters of every variant, e.g. from ExpandSweepGrid.
+   * @param ordering The order in which simulations store sensors and targets.
+   * @param thread_num The number of threads running variants, or 0 for all hardware threads.
+   * @throws std::runtime_error if the scenario or any variant is invalid, or there are no variants.
+   */
+  ParameterSweep(SimulationScenario scenario, std::vector<SimulationParameters> variants,
+                 SpatialOrdering ordering = SpatialOrdering::kInput, uint32_t thread_num = 0);
+  const std::vector<SimulationParameters> &GetVariants() const { return variants_; } ///< Gets the parameters of every variant.
+  /**
+   * @brief Runs all variants.
+   * @param control Optional progress and cancellation flag. Progress is the fraction of finished variants.
+   * @return One row per variant, in the order of the variants.
+   * @throws std::runtime_error on cancellation.
+   */
+  std::vector<SweepResult> Run(TaskControl *control = nullptr) const;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+#include "shared/simulation_structures.hpp"
+#include "api/MappedFile.hpp"
+/**
+ * @file PointFile.hpp
+ * @brief Contains the reader and writer of binary point files, a compact scenario format for large deployments.
+ * @details A file starts with a 32 byte PointFileHeader, followed by target_num target positions and
+ * sensor_num sensor positions. Every position is two little-endian float64 values, x then y,
+ * so the positions have the layout of Point and are used in place, without parsing.
+ * The file can also be written directly, e.g. with numpy.ndarray.tofile.
+ */
+
+/**
+ * @struct PointFileHeader
+ * @brief Header of a binary point file.
+ */
+struct PointFileHeader
+{
+  static constexpr char kMagic[8] = "WSNPTS"; ///< Expected value of magic.
+  static constexpr uint32_t kVersion = 1;     ///< Current version of the format.
+
+  char magic[8];       ///< Identifies the format, equal to kMagic.
+  uint32_t version;    ///< Version of the format.
+  uint32_t reserved;   ///< Unused, zero.
+  uint64_t target_num; ///< Number of target positions.
+  uint64_t sensor_num; ///< Number of sensor positions.
+};
+static_assert(sizeof(PointFileHeader) == 32, "PointFileHeader must be 32 bytes");
+
+/**
+ * @class PointFile
+ * @brief Read-only access to the positions of a binary point file.
+ * @details The file is memory mapped and the positions are viewed where they lie in the mapping,
+ * so opening a file with millions of positions costs no copy and pages are read from disk on first use.
+ */
+class PointFile
+{
+  MappedFile file_;        ///< The mapped file.
+  ScenarioView positions_; ///< Positions within the mapping.
+
+public:
+  /**
+   * @brief Opens a binary point file.
+   * @param path The path to the file.
+   * @exception Throws std::runtime_error if the file cannot be mapped or is not a valid point file.
+   */
+  explicit PointFile(const std::string &path);
+  ScenarioView GetPositions() const { return positions_; } ///< Gets the positions, valid as long as the file is open.
+};
+
+/**
+ * @brief Writes positions to a binary point file, replacing its content.
+ * @param path The path to the output file.
+ * @param scenario The positions to write.
+ * @exception Throws std::runtime_error if the file cannot be written.
+ */
+void WritePointFile(const std::string &path, ScenarioView scenario);
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+
+#include "shared/simulation_structures.hpp"
+/**
+ * @file ScenarioGenerator.hpp
+ * @brief Contains the generator of random scenarios.
+ */
+
+enum class ScenarioLayout ///< The distribution of generated positions.
+{
+  kUniform,         ///< Uniform in the unit square.
+  kRadial,          ///< Clustered around the center of the unit square, the distribution of generate_positions.py.
+  kGaussianMixture, ///< Gaussian clusters in the unit square. Targets and sensors share the cluster centers.
+  kJitteredGrid,    ///< A grid covering the unit square, every point displaced randomly within its cell.
+  kPoissonDisk,     ///< Uniform, but no two points of the same kind closer than a minimum distance.
+};
+
+/**
+ * @struct ScenarioGeneratorOptions
+ * @brief Options of GenerateScenario.
+ */
+struct ScenarioGeneratorOptions
+{
+  ScenarioLayout layout = ScenarioLayout::kUniform; ///< The distribution of positions.
+  uint64_t seed = 0;                                ///< The seed. Equal seeds and options give equal scenarios on any number of threads.
+  uint32_t cluster_num = 8;                         ///< kGaussianMixture: the number of clusters.
+  double cluster_spread = 0.05;                     ///< kGaussianMixture: the standard deviation of a cluster.
+  double jitter = 1.0;                              ///< kJitteredGrid: the displacement as a fraction of a cell, from 0 (exact grid) to 1 (anywhere in the cell).
+  double min_distance = 0.0;                        ///< kPoissonDisk: the minimum distance, or 0 to derive it from the number of points.
+  double neighborhood_radius = 0.0;                 ///< If positive, the neighborhood limit is respected for this sensor radius, see GenerateScenario.
+};
+
+/**
+ * @brief Generates a random scenario.
+ * @details Every position is drawn from its own random stream, derived from the seed and its index,
+ * so positions are generated in parallel and the result does not depend on the number of threads.
+ * kPoissonDisk throws darts at a background grid in phases of cells far enough apart to be filled concurrently,
+ * then picks the requested number of points from the result in random order.
+ *
+ * With a positive neighborhood_radius, candidates are accepted in order only if no sensor would get more than
+ * bit_vec_size sensors or targets closer than the radius, and rejected ones are replaced by further candidates.
+ * Such a scenario never fails Sensor::Initialize for that radius. This pass is sequential.
+ * @param target_num The number of targets.
+ * @param sensor_num The number of sensors.
+ * @param options The layout, its settings and the seed.
+ * @return The generated scenario.
+ * @throws std::runtime_error if the options are invalid or the points do not fit under the constraints.
+ */
+SimulationScenario GenerateScenario(uint32_t target_num, uint32_t sensor_num, const ScenarioGeneratorOptions &options = {});
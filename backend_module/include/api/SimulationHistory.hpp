@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+#include "core/Sensor.hpp"
+#include "shared/simulation_structures.hpp"
+#include "api/StateSink.hpp"
+/**
+ * @file SimulationHistory.hpp
+ * @brief Contains the SimulationHistory class that stores simulation states as keyframes and per-tick deltas.
+ */
+
+/**
+ * @class SimulationHistory
+ * @brief Compact store of consecutive simulation states.
+ * @details Instead of full copies, every state is stored as a difference to the previous one:
+ * sensor state transitions and target coverage flips. Battery levels are not stored at all when they follow
+ * the protocol, i.e. a sensor loses one unit in every tick it spends on (including the tick it dies in).
+ * A full keyframe is kept every keyframe_interval states, so any state can be rebuilt by replaying at most
+ * keyframe_interval deltas.
+ */
+class SimulationHistory : public StateSink
+{
+  /**
+   * @struct StateChange
+   * @brief A sensor switching to a new state.
+   */
+  struct StateChange
+  {
+    uint32_t sensor;     ///< Index of the sensor.
+    Sensor::State state; ///< The new state of the sensor.
+  };
+  /**
+   * @struct BatteryFix
+   * @brief A battery level that cannot be derived from the state of the sensor.
+   */
+  struct BatteryFix
+  {
+    uint32_t sensor;     ///< Index of the sensor.
+    int32_t battery_lvl; ///< The battery level of the sensor.
+  };
+  /**
+   * @struct TickRecord
+   * @brief Per-state summary with the end offsets of its deltas.
+   */
+  struct TickRecord
+  {
+    uint32_t tick;                 ///< The tick of the state.
+    uint32_t covered_target_count; ///< The count of covered targets.
+    size_t changes_end;            ///< End of the state changes of this record in changes_.
+    size_t flips_end;              ///< End of the coverage flips of this record in flips_.
+    size_t fixes_end;              ///< End of the battery fixes of this record in fixes_.
+  };
+
+  uint32_t keyframe_interval_;             ///< Number of states between two keyframes.
+  size_t sensor_num_ = 0;                  ///< Number of sensors in every state.
+  size_t target_num_ = 0;                  ///< Number of targets in every state.
+  std::vector<TickRecord> records_;        ///< Summary of every recorded state.
+  std::vector<StateChange> changes_;       ///< Sensor state transitions of all records.
+  std::vector<uint32_t> flips_;            ///< Indices of targets whose coverage flipped, for all records.
+  std::vector<BatteryFix> fixes_;          ///< Battery levels that do not follow the protocol, for all records.
+  std::vector<SimulationState> keyframes_; ///< Full states of records 0, keyframe_interval, 2 * keyframe_interval, ...
+  SimulationState last_;                   ///< The last recorded state, used for computing the next delta.
+
+public:
+  /**
+   * @brief Constructs an empty history.
+   * @param keyframe_interval Number of states between two keyframes. Must be positive.
+   */
+  explicit SimulationHistory(uint32_t keyframe_interval = 1024);
+  /**
+   * @brief Appends a state to the history.
+   * @param state The state following the last recorded one.
+   * @exception Throws std::runtime_error if the number of sensors or targets differs from the previous states.
+   */
+  void Record(const SimulationState &state);
+  /**
+   * @brief Appends a state to the history, taking over its vectors.
+   * @details The state keeps the vectors of the previously recorded state in exchange, which already have
+   * the right sizes, so refilling it for the next tick allocates nothing.
+   * @param state The state following the last recorded one.
+   * @exception Throws std::runtime_error if the number of sensors or targets differs from the previous states.
+   */
+  void Push(SimulationState &&state) override;
+  size_t Size() const { return records_.size(); }     ///< Gets the number of recorded states.
+  bool Empty() const { return records_.empty(); }     ///< Checks if no state has been recorded.
+  size_t GetSensorNum() const { return sensor_num_; } ///< Gets the number of sensors in every state.
+  size_t GetTargetNum() const { return target_num_; } ///< Gets the number of targets in every state.
+  /**
+   * @brief Rebuilds the state recorded at a given tick.
+   * @param tick The tick of the state.
+   * @return The rebuilt state.
+   * @exception Throws std::runtime_error if no state was recorded at the tick.
+   */
+  SimulationState GetStateAt(uint32_t tick) const;
+  /**
+   * @brief Rebuilds all recorded states.
+   * @return The states in recording order.
+   */
+  std::vector<SimulationState> GetStates() const;
+  /**
+   * @brief Rebuilds the recorded states one by one, without keeping them.
+   * @param f Function called with every state in recording order. The reference is valid only during the call.
+   */
+  template <typename F>
+  void ForEachState(F &&f) const
+  {
+    SimulationState state;
+    for (size_t i = 0; i < records_.size(); ++i)
+    {
+      if (i % keyframe_interval_ == 0)
+      {
+        state = keyframes_[i / keyframe_interval_];
+      }
+      else
+      {
+        Apply(state, i);
+      }
+      f(static_cast<const SimulationState &>(state));
+    }
+  }
+  /**
+   * @brief Removes all recorded states.
+   */
+  void Clear();
+  /**
+   * @brief Gets the approximate number of bytes used by the history.
+   * @return The size of all stored records, deltas and keyframes.
+   */
+  size_t MemoryUsage() const;
+
+private:
+  /**
+   * @brief Appends the record and the deltas of a state, without updating last_.
+   * @param state The state following the last recorded one.
+   * @exception Throws std::runtime_error if the number of sensors or targets differs from the previous states.
+   */
+  void AppendRecord(const SimulationState &state);
+  /**
+   * @brief Rebuilds the state of a given record.
+   * @param index The index of the record.
+   * @return The rebuilt state.
+   */
+  SimulationState Rebuild(size_t index) const;
+  /**
+   * @brief Applies the deltas of a record to the state of the previous one.
+   * @param state The state of the previous record, turned into the state of the given record.
+   * @param index The index of the record to apply.
+   */
+  void Apply(SimulationState &state, size_t index) const;
+  /**
+   * @brief Fills the summary fields of a state from a record.
+   * @param state The state to fill.
+   * @param record The record holding the summary.
+   */
+  void FillSummary(SimulationState &state, const TickRecord &record) const;
+};
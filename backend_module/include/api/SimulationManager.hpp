@@ -1,9 +1,22 @@
 #pragma once
 #include <vector>
 #include <optional>
+#include <memory>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <cmath>
 
 #include "core/Simulation.hpp"
+#include "api/SimulationHistory.hpp"
+#include "api/HistoryArrays.hpp"
+#include "api/BinaryHistory.hpp"
+#include "api/Checkpoint.hpp"
+#include "api/StateSink.hpp"
+#include "api/SimulationTask.hpp"
+#include "api/ConfigReader.hpp"
+#include "api/PointFile.hpp"
+#include "api/ScenarioGenerator.hpp"
 #include "shared/utility.hpp"
 #include "shared/simulation_structures.hpp"
 #include "api/json.hpp"
@@ -17,22 +30,88 @@
  * @brief Manages the lifecycle of a simulation, including parameters, scenario, and states.
  * @details This class initializes the simulation with parameters and scenario, runs the simulation, and manages its states.
  * @note all methods checks correctness of data and throws std::runtime_error if data is not set or incorrect.
+ * While a task started by InitializeAsync or RunAsync is running, all methods except GetParameters and GetScenario
+ * throw std::runtime_error; the task handle is the only way to interact with the manager until it finishes.
  */
 class SimulationManager
 {
-  std::optional<SimulationParameters> parameters_; ///< The parameters for the simulation, such as sensor radius, initial battery level, reshuffle interval, etc.
-  std::optional<SimulationScenario> scenario_;     ///< The scenario for the simulation, including target and sensor positions.
-  std::optional<Simulation> simulation_;           ///< The simulation instance.
-  std::vector<SimulationState> states_;            ///< The states of the simulation.
-  bool is_initialized_ = false;                    ///< Flag indicating whether the simulation has been initialized.
+  std::optional<SimulationParameters> parameters_;             ///< The parameters for the simulation, such as sensor radius, initial battery level, reshuffle interval, etc.
+  mutable std::optional<SimulationScenario> scenario_;         ///< The scenario for the simulation, including target and sensor positions.
+  std::shared_ptr<const PointFile> scenario_file_;             ///< The point file the scenario was loaded from, if any. Its positions are used in place.
+  std::optional<Simulation> simulation_;                       ///< The simulation instance.
+  SimulationHistory history_;                                  ///< The states of the simulation, stored as deltas.
+  std::shared_ptr<StateSink> sink_;                            ///< Custom consumer of states. If not set, states go to history_.
+  bool is_initialized_ = false;                                ///< Flag indicating whether the simulation has been initialized.
+  bool is_finished_ = false;                                   ///< Flag indicating whether the simulation reached max ticks or its stop condition.
+  uint32_t ticks_run_ = 0;                                     ///< Number of ticks the simulation has advanced since initialization.
+  SpatialOrdering spatial_ordering_ = SpatialOrdering::kInput; ///< The order in which the simulation stores sensors and targets.
+  std::shared_ptr<SimulationTask> task_;                       ///< The last background task, if any.
+  mutable std::shared_ptr<HistoryArrays> arrays_;              ///< Dense copy of the history, rebuilt when the history grows.
+  std::optional<uint64_t> layout_hash_;                        ///< Content hash of the layout of the simulation, once a checkpoint needed it.
+  SimulationState state_buffer_;                               ///< State refilled every tick, so its vectors are allocated only once per run.
 
 public:
-  const SimulationParameters &GetParameters() const;                                  ///< Gets the parameters for the simulation.
-  const SimulationScenario &GetScenario() const;                                      ///< Gets the scenario for the simulation.
-  const std::vector<SimulationState> &GetSimulationStates() const { return states_; } ///< Gets the states of the simulation.
-  bool IsInitialized() const { return is_initialized_; }                              ///< Checks if the simulation has been initialized.
-  void SetParameters(const SimulationParameters &parameters);                         ///< Sets the parameters for the simulation.
-  void SetScenario(const SimulationScenario &scenario);                               ///< Sets the scenario for the simulation.
+  SimulationManager() = default;
+  /**
+   * @brief Cancels the background task, if any, and waits for it to finish.
+   */
+  ~SimulationManager();
+  const SimulationParameters &GetParameters() const;                                                      ///< Gets the parameters for the simulation.
+  const SimulationScenario &GetScenario() const;                                                          ///< Gets the scenario for the simulation. A scenario mapped from a point file is copied on the first call.
+  std::vector<SimulationState> GetSimulationStates() const { EnsureIdle(); return history_.GetStates(); } ///< Rebuilds all states of the simulation.
+  size_t GetStateCount() const { EnsureIdle(); return history_.Size(); }                                  ///< Gets the number of recorded states.
+  bool IsInitialized() const { EnsureIdle(); return is_initialized_; }                                    ///< Checks if the simulation has been initialized.
+  bool IsFinished() const { EnsureIdle(); return is_finished_; }                                          ///< Checks if the simulation reached max ticks or its stop condition.
+  uint32_t GetTicksRun() const { EnsureIdle(); return ticks_run_; }                                       ///< Gets the number of ticks run since initialization.
+  void SetParameters(const SimulationParameters &parameters);                                             ///< Sets the parameters for the simulation.
+  void SetScenario(const SimulationScenario &scenario);                                                   ///< Sets the scenario for the simulation.
+  void SetScenario(SimulationScenario &&scenario);                                                        ///< Sets the scenario for the simulation, taking over its positions.
+  /**
+   * @brief Sets the scenario from interleaved coordinates, e.g. the buffers of (N, 2) float64 arrays.
+   * @param target_coords Coordinates x0, y0, x1, y1, ... of targets.
+   * @param target_num The number of targets.
+   * @param sensor_coords Coordinates x0, y0, x1, y1, ... of sensors.
+   * @param sensor_num The number of sensors.
+   */
+  void SetScenario(const double *target_coords, size_t target_num, const double *sensor_coords, size_t sensor_num);
+  /**
+   * @brief Rebuilds the state of the simulation at a given tick.
+   * @param tick The tick of the state.
+   * @return The state at the given tick.
+   * @throws std::runtime_error if no state was recorded at the tick.
+   */
+  SimulationState GetStateAt(uint32_t tick) const { EnsureIdle(); return history_.GetStateAt(tick); }
+  /**
+   * @brief Gets the recorded states as dense arrays.
+   * @details The arrays are decoded from the history once and shared by later calls until more states are recorded.
+   * Previously returned arrays are never modified.
+   * @return The recorded states, one row per state.
+   */
+  std::shared_ptr<HistoryArrays> GetHistoryArrays() const;
+  /**
+   * @brief Sets the order in which the simulation stores sensors and targets.
+   * @details Renumbering along a space-filling curve places neighbors close in memory and speeds up reshuffles.
+   * The reported states are in scenario order regardless of this setting.
+   * @note Reshuffles visit sensors in the stored order, so results may differ slightly from SpatialOrdering::kInput.
+   * @param ordering The ordering to use during initialization.
+   */
+  void SetSpatialOrdering(SpatialOrdering ordering);
+  /**
+   * @brief Sets the consumer of states produced by Run.
+   * @details By default states are recorded in the history of the manager. With a custom sink they are pushed
+   * to the sink as soon as they are produced and the history stays empty, so e.g. a ring buffer or a file sink
+   * lets arbitrarily long runs finish in constant memory.
+   * @param sink The sink, or nullptr to record states in the history again.
+   */
+  void SetStateSink(std::shared_ptr<StateSink> sink);
+  std::shared_ptr<StateSink> GetStateSink() const { return sink_; } ///< Gets the custom consumer of states, if any.
+  /**
+   * @brief Loads parameters and scenario from a JSON file, reading and parsing it once.
+   * @details The scenario is streamed straight into the position vectors, see ReadConfigJSON.
+   * @param json_path The path to the JSON file containing the "parameters" and "scenario" fields.
+   * @throws std::runtime_error if the file cannot be read or lacks either field. Nothing is loaded in that case.
+   */
+  void LoadConfigFromJSON(const std::string &json_path);
   /**
    * @brief Loads parameters from a JSON file.
    * @param json_path The path to the JSON file containing simulation parameters.
@@ -43,8 +122,60 @@ public:
    * @param json_path The path to the JSON file containing simulation scenario.
    */
   void LoadScenarioFromJSON(const std::string &json_path);
+  /**
+   * @brief Loads scenario from a CSV file of `kind,x,y` lines, parsed in parallel.
+   * @details See ReadScenarioCSV for the format.
+   * @param csv_path The path to the CSV file.
+   */
+  void LoadScenarioFromCSV(const std::string &csv_path);
+  /**
+   * @brief Loads scenario from a binary point file.
+   * @details The file stays memory mapped and Initialize places targets and sensors straight from the mapping,
+   * so no intermediate position vectors are built. See PointFile.hpp for the format.
+   * @param path The path to the point file.
+   */
+  void LoadScenarioFromBinary(const std::string &path);
+  /**
+   * @brief Writes the scenario to a binary point file, e.g. to convert a JSON or CSV scenario once and load it quickly later.
+   * @param path The path to the output file.
+   */
+  void DumpScenarioToBinary(const std::string &path) const;
   void DumpStatesToJSON(const std::string &json_path) const;         ///< Dumps the states of the simulation to a JSON file. Currently not used
-  void LoadRandomScenario(uint32_t target_num, uint32_t sensor_num); ///< Loads a random scenario with specified number of targets and sensors. Currently not used
+  /**
+   * @brief Dumps the recorded states to a file in the binary columnar history format.
+   * @details States are decoded from the history and written one by one, without materializing all of them.
+   * Use BinaryStateSink to write the file during the run instead.
+   * @param path The path to the output file.
+   */
+  void DumpStatesToBinary(const std::string &path) const;
+  /**
+   * @brief Saves the running simulation to a checkpoint file.
+   * @details Only the mutable runtime is written to the file: tick, sensor states and batteries, current covers,
+   * cover order and target coverage, along with the parameters. Positions, neighborhoods and covers go to a
+   * layout file next to it, named after their content hash; it is written only if it does not exist yet, so
+   * repeated checkpoints of a run cost O(sensors + targets + covers). Recorded states are not part of a checkpoint,
+   * use a BinaryStateSink to keep them across processes.
+   * @param path The path to the checkpoint file, replaced atomically.
+   * @throws std::runtime_error if the simulation is not initialized or a file cannot be written.
+   */
+  void SaveCheckpoint(const std::string &path);
+  /**
+   * @brief Restores a simulation saved with SaveCheckpoint, replacing parameters, scenario and simulation.
+   * @details Files are memory mapped and copied in bulk, no covers are generated. The restored simulation
+   * continues exactly like the saved one would have. The history starts empty; the state sink is kept.
+   * @param path The path to the checkpoint file. Its layout file must be in the same directory.
+   * @throws std::runtime_error if a file is missing, invalid or corrupted. The manager is unchanged in that case.
+   */
+  void LoadCheckpoint(const std::string &path);
+  void LoadRandomScenario(uint32_t target_num, uint32_t sensor_num); ///< Loads a uniform random scenario with specified number of targets and sensors. Currently not used
+  /**
+   * @brief Loads a scenario generated with GenerateScenario.
+   * @param target_num The number of targets.
+   * @param sensor_num The number of sensors.
+   * @param options The layout, its settings and the seed. Set neighborhood_radius to the sensor radius
+   * to get a scenario that never exceeds the neighborhood limit during initialization.
+   */
+  void LoadGeneratedScenario(uint32_t target_num, uint32_t sensor_num, const ScenarioGeneratorOptions &options);
   /**
    * @brief Initializes the simulation manager with parameters and scenario.
    * @details This method initializes the simulation with the provided parameters and scenario.
@@ -53,29 +184,145 @@ public:
   void Initialize();
   /**
    * @brief Runs the simulation.
-   * @details This method runs the simulation for a maximum number of ticks defined in the parameters.
-   * It updates the states of the simulation and checks if the simulation should stop based on the stop condition.
+   * @details This method runs the simulation until it reaches the maximum number of ticks defined in the parameters
+   * or its stop condition, continuing from where previous Step, RunFor or RunUntil calls left off.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
    */
   void Run();
+  /**
+   * @brief Runs the simulation to its end without producing any state.
+   * @details Like Run, but no SimulationState is built, so nothing reaches the sink or the history. Only aggregate
+   * counters are maintained, which leaves the protocol itself as the per-tick cost. Use it when only the lifetime
+   * and coverage statistics of a run matter.
+   * @return The summary of the ticks run by this call.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  RunSummary RunSummarized();
+  /**
+   * @brief Advances the simulation by a single tick.
+   * @details The new state is also passed to the sink or the history, as in Run.
+   * @return The new state.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  SimulationState Step();
+  /**
+   * @brief Advances the simulation by up to a given number of ticks.
+   * @details Stops earlier if the simulation finishes.
+   * @param tick_num The number of ticks to run. Must be positive.
+   * @return The last new state.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  SimulationState RunFor(uint32_t tick_num);
+  /**
+   * @brief Advances the simulation until a predicate holds for the new state.
+   * @details Stops earlier if the simulation finishes.
+   * @param predicate Function checking each new state, e.g. a Python callable.
+   * @return The first state satisfying the predicate, or the last state if the simulation finished first.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  SimulationState RunUntil(const std::function<bool(const SimulationState &)> &predicate);
+  /**
+   * @brief Starts Initialize on a worker thread.
+   * @details Progress follows the generation of covers. A cancelled initialization leaves the manager uninitialized,
+   * so it can be initialized again.
+   * @return Handle to the running initialization; its Wait rethrows errors of Initialize.
+   * @throws std::runtime_error if parameters or scenario are not set or the simulation is already initialized.
+   */
+  std::shared_ptr<SimulationTask> InitializeAsync();
+  /**
+   * @brief Starts Run on a worker thread.
+   * @details Progress is the fraction of max ticks run so far. A cancelled run stops after the current tick
+   * and can be continued later.
+   * @return Handle to the running simulation.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  std::shared_ptr<SimulationTask> RunAsync();
   /**
    * @brief Resets the simulation manager.
    * @details This method resets the parameters, scenario, simulation, and states.
    * It can be called to reinitialize the simulation manager with new parameters or scenario.
    */
   void Reset();
-
-private:
   /**
-   * @brief Loads JSON data from a file.
-   * @param json_path The path to the JSON file.
-   * @return The loaded JSON data.
-   * @throws std::runtime_error if the file cannot be opened or parsed.
+   * @brief Checks that parameters describe a runnable simulation.
+   * @param parameters The parameters to check.
+   * @throws std::runtime_error if any parameter is out of range.
+   */
+  static void ValidateParameters(const SimulationParameters &parameters);
+  /**
+   * @brief Checks that a scenario has targets and sensors and all their positions are finite.
+   * @param scenario The scenario to check.
+   * @throws std::runtime_error if the scenario is invalid.
    */
-  json LoadJSON(const std::string &json_path);
+  static void ValidateScenario(ScenarioView scenario);
   /**
-   * @brief Checks if the simulation should stop based on the current state and parameters.
+   * @brief Checks if a simulation should stop based on its current state and parameters.
+   * @param parameters The parameters of the simulation, holding the stop condition.
    * @param state The current state of the simulation.
    * @return True if the simulation should stop, false otherwise.
    */
-  bool ShouldStop(const SimulationState &state) const;
+  static bool ShouldStop(const SimulationParameters &parameters, const SimulationState &state);
+  /**
+   * @brief Runs a simulation until it finishes, keeping only aggregate counters.
+   * @details This is the tick loop shared by RunSummarized, BatchRunner and ParameterSweep.
+   * @param simulation The initialized simulation.
+   * @param parameters The parameters of the simulation, holding the stop condition and max ticks.
+   * @param ticks_run The number of ticks the simulation has run already.
+   * @param control Optional cancellation flag, checked after every tick.
+   * @param on_tick Optional function receiving the number of covered targets after every tick.
+   * @return The summary of the ticks run by this call; finished is false if it was cancelled.
+   */
+  static RunSummary RunToEnd(Simulation &simulation, const SimulationParameters &parameters, uint32_t ticks_run = 0,
+                             TaskControl *control = nullptr, const std::function<void(uint32_t)> &on_tick = {});
+
+private:
+  /**
+   * @brief Checks that all positions have finite coordinates.
+   * @param positions The positions to check.
+   * @param name The name of the positions used in the error message.
+   * @throws std::runtime_error if any coordinate is infinite or NaN.
+   */
+  static void ValidatePositions(std::span<const Point> positions, const std::string &name);
+  bool HasScenario() const { return scenario_.has_value() || scenario_file_; } ///< Checks if a scenario is set, in memory or mapped.
+  /**
+   * @brief Gets the positions of the scenario, wherever they are stored.
+   * @return A view of the positions, valid until the scenario changes.
+   * @throws std::runtime_error if the scenario is not set.
+   */
+  ScenarioView GetScenarioView() const;
+  /**
+   * @brief Checks that no background task is using the manager.
+   * @throws std::runtime_error if a task started by InitializeAsync or RunAsync is still running.
+   */
+  void EnsureIdle() const;
+  /**
+   * @brief Checks that the simulation can be initialized.
+   * @throws std::runtime_error if parameters or scenario are not set or the simulation is already initialized.
+   */
+  void CheckInitializable() const;
+  /**
+   * @brief Checks that the simulation can be advanced.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  void CheckRunnable() const;
+  /**
+   * @brief Creates and initializes the simulation.
+   * @param control Optional progress and cancellation flag.
+   */
+  void InitializeSimulation(TaskControl *control);
+  /**
+   * @brief Advances the simulation tick by tick until it finishes, a tick limit is hit or a predicate holds.
+   * @param tick_num The maximum number of ticks to run.
+   * @param predicate Function checking each new state, may be empty.
+   * @param last Receives a copy of the last new state, may be null when the caller does not need it.
+   * @param control Optional progress and cancellation flag. Cancellation stops the simulation after the current tick.
+   * @throws std::runtime_error if the simulation is not initialized or already finished.
+   */
+  void Advance(uint32_t tick_num, const std::function<bool(const SimulationState &)> &predicate, SimulationState *last, TaskControl *control = nullptr);
+  /**
+   * @brief Passes a state to the custom sink or to the history.
+   * @details A sink keeping states takes over the buffers of the state, one that does not leaves them for reuse.
+   * @param state The state to pass.
+   */
+  void Emit(SimulationState &&state);
 };
\ No newline at end of file
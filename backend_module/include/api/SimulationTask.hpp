@@ -0,0 +1,50 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+#include "core/TaskControl.hpp"
+/**
+ * @file SimulationTask.hpp
+ * @brief Contains the SimulationTask class, a handle to work running on a native worker thread.
+ */
+
+/**
+ * @class SimulationTask
+ * @brief Future-like handle to a simulation call running in the background.
+ * @details The work starts on its own thread as soon as the task is constructed.
+ * The handle reports progress, requests cancellation and waits for the result.
+ */
+class SimulationTask
+{
+  TaskControl control_;                  ///< Progress and cancellation flag shared with the work.
+  bool is_done_ = false;                 ///< Flag indicating whether the work has returned or thrown, guarded by mutex_.
+  std::exception_ptr error_;             ///< Exception thrown by the work, if any.
+  mutable std::mutex mutex_;             ///< Guards is_done_ and error_.
+  mutable std::condition_variable done_; ///< Signalled when the work finishes.
+  std::thread worker_;                   ///< The thread running the work.
+
+public:
+  /**
+   * @brief Starts the work on a new thread.
+   * @param work Function doing the work. It should report progress and poll for cancellation through its argument.
+   */
+  explicit SimulationTask(std::function<void(TaskControl &)> work);
+  /**
+   * @brief Requests cancellation and waits for the work to finish.
+   */
+  ~SimulationTask();
+  SimulationTask(const SimulationTask &) = delete;
+  SimulationTask &operator=(const SimulationTask &) = delete;
+  bool IsDone() const;                                          ///< Checks if the work has finished, successfully or not.
+  float GetProgress() const { return control_.GetProgress(); } ///< Gets the fraction of the work done.
+  void Cancel() { control_.Cancel(); }                          ///< Requests cancellation; the work stops at its next check.
+  bool IsCancelled() const { return control_.IsCancelled(); }   ///< Checks if cancellation was requested.
+  /**
+   * @brief Blocks until the work finishes.
+   * @exception Rethrows the exception thrown by the work, if any.
+   */
+  void Wait() const;
+};
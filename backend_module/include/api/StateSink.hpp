@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+#include "shared/simulation_structures.hpp"
+#include "api/JsonStateWriter.hpp"
+/**
+ * @file StateSink.hpp
+ * @brief Contains the StateSink interface and its basic implementations, which consume states produced by a simulation run.
+ */
+
+/**
+ * @class StateSink
+ * @brief Consumer of simulation states.
+ * @details SimulationManager pushes every state to its sink as soon as the state is produced,
+ * so the sink decides how much of the run is kept in memory.
+ */
+class StateSink
+{
+public:
+  virtual ~StateSink() = default;
+  /**
+   * @brief Consumes a state.
+   * @param state The state to consume. The sink may take over its buffers, and may hand back buffers
+   * of a state it no longer needs in their place, for the producer to refill.
+   */
+  virtual void Push(SimulationState &&state) = 0;
+  /**
+   * @brief Writes out any buffered data.
+   * @note Called at the end of every run.
+   */
+  virtual void Flush() {}
+};
+
+/**
+ * @class VectorStateSink
+ * @brief Keeps every state in a vector.
+ */
+class VectorStateSink : public StateSink
+{
+  std::vector<SimulationState> states_; ///< The consumed states.
+
+public:
+  void Push(SimulationState &&state) override { states_.emplace_back(std::move(state)); }
+  const std::vector<SimulationState> &GetStates() const { return states_; } ///< Gets the consumed states.
+  void Clear() { states_.clear(); }                                         ///< Removes all consumed states.
+};
+
+/**
+ * @class RingBufferStateSink
+ * @brief Keeps only a fixed number of the most recent states.
+ */
+class RingBufferStateSink : public StateSink
+{
+  size_t capacity_;                     ///< Maximum number of kept states.
+  size_t next_ = 0;                     ///< Slot that the next state overwrites once the buffer is full.
+  std::vector<SimulationState> buffer_; ///< The kept states.
+
+public:
+  /**
+   * @brief Constructs an empty ring buffer.
+   * @param capacity Maximum number of kept states. Must be positive.
+   */
+  explicit RingBufferStateSink(size_t capacity);
+  void Push(SimulationState &&state) override;
+  size_t GetCapacity() const { return capacity_; }  ///< Gets the maximum number of kept states.
+  size_t GetSize() const { return buffer_.size(); } ///< Gets the number of kept states.
+  /**
+   * @brief Gets the kept states.
+   * @return Copies of the kept states, from the oldest to the most recent one.
+   */
+  std::vector<SimulationState> GetStates() const;
+};
+
+/**
+ * @class FileStateSink
+ * @brief Writes every state to a file as one line of compact JSON (JSON Lines).
+ */
+class FileStateSink : public StateSink
+{
+  std::ofstream file_; ///< The output file.
+  std::string line_;   ///< Reused buffer for the current line.
+
+public:
+  /**
+   * @brief Opens the output file, replacing its content.
+   * @param path The path to the output file.
+   * @exception Throws std::runtime_error if the file cannot be opened.
+   */
+  explicit FileStateSink(const std::string &path);
+  void Push(SimulationState &&state) override;
+  void Flush() override { file_.flush(); }
+};
+
+/**
+ * @class JsonStateSink
+ * @brief Writes all states to a file as a single JSON array, in the format of SimulationManager::DumpStatesToJSON.
+ * @details States are formatted as they arrive. Flush closes the array, so the file is valid JSON after every run,
+ * and the closing bracket is overwritten if more states follow.
+ */
+class JsonStateSink : public StateSink
+{
+  std::ofstream file_;     ///< The output file.
+  JsonStateWriter writer_; ///< Formats the states into file_.
+
+public:
+  /**
+   * @brief Opens the output file, replacing its content.
+   * @param path The path to the output file.
+   * @param indent Number of spaces per indentation level, or -1 for compact output.
+   * @exception Throws std::runtime_error if the file cannot be opened.
+   */
+  explicit JsonStateSink(const std::string &path, int indent = -1);
+  /**
+   * @brief Closes the array.
+   */
+  ~JsonStateSink() override;
+  void Push(SimulationState &&state) override { writer_.Write(state); } ///< Appends a state to the array.
+  void Flush() override;
+};
+
+/**
+ * @class CallbackStateSink
+ * @brief Passes every state to a user supplied function, e.g. a Python callable.
+ */
+class CallbackStateSink : public StateSink
+{
+  std::function<void(const SimulationState &)> callback_; ///< The function receiving states.
+
+public:
+  /**
+   * @brief Constructs the sink.
+   * @param callback The function receiving states.
+   */
+  explicit CallbackStateSink(std::function<void(const SimulationState &)> callback) : callback_(std::move(callback)) {}
+  void Push(SimulationState &&state) override { callback_(state); }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <stdexcept>
+
+#include "core/cover_structures.hpp"
+#include "core/SpatialGrid.hpp"
+/**
+ * @file CoverStorage.hpp
+ * @brief Defines the CoverStorage class holding the data of a simulation that depends only on its geometry.
+ */
+
+/**
+ * @class CoverStorage
+ * @brief Neighborhoods, covers and LDGraphs of all sensors, stored in flat arrays and referenced by index.
+ * @details Everything here follows from the positions and the sensor radius and never changes while the simulation runs,
+ * so clones and forks of a simulation share one instance. Sensors, targets and covers refer to each other by index,
+ * which stays valid in every copy. Covers of sensor s are storage indices CoverBegin(s) ... CoverEnd(s) - 1.
+ */
+class CoverStorage
+{
+  CsrGraph sensor_targets_;              ///< Local targets of every sensor.
+  CsrGraph sensor_sensors_;              ///< Local sensors of every sensor.
+  std::vector<uint32_t> cover_offsets_;  ///< Index of the first cover of each sensor, followed by the total cover count.
+  std::vector<Cover> initial_covers_;    ///< Records of all covers as generated, before any reshuffle.
+  std::vector<uint32_t> edge_offsets_;   ///< Offset of the first LDGraph edge of each cover, followed by the total edge count.
+  std::vector<Edge> edges_;              ///< LDGraph edges of all covers. The cover index of an edge is local to the sensor.
+
+public:
+  /**
+   * @brief Constructs a storage without covers.
+   * @param sensor_targets The local targets of every sensor.
+   * @param sensor_sensors The local sensors of every sensor.
+   */
+  CoverStorage(CsrGraph sensor_targets, CsrGraph sensor_sensors);
+  /**
+   * @brief Constructs a storage from all of its arrays, e.g. read back from a file.
+   * @param sensor_targets The local targets of every sensor.
+   * @param sensor_sensors The local sensors of every sensor.
+   * @param cover_offsets Index of the first cover of each sensor, followed by the total cover count.
+   * @param initial_covers Records of all covers as generated.
+   * @param edge_offsets Offset of the first LDGraph edge of each cover, followed by the total edge count.
+   * @param edges LDGraph edges of all covers.
+   * @exception Throws std::runtime_error if the sizes of the arrays do not fit together.
+   */
+  CoverStorage(CsrGraph sensor_targets, CsrGraph sensor_sensors, std::vector<uint32_t> cover_offsets, std::vector<Cover> initial_covers,
+               std::vector<uint32_t> edge_offsets, std::vector<Edge> edges);
+  /**
+   * @brief Appends the covers of the next sensors.
+   * @details Every sensor must be appended once, in order. The arrays are grown once, to their final size.
+   * @param batches The generated covers of consecutive sensors, in order.
+   */
+  void AppendCovers(std::span<const LocalCovers> batches);
+  size_t GetSensorNum() const { return sensor_sensors_.offsets.size() - 1; }        ///< Gets the number of sensors.
+  size_t GetCoverNum() const { return initial_covers_.size(); }                     ///< Gets the number of covers of all sensors.
+  uint32_t CoverBegin(size_t sensor) const { return cover_offsets_[sensor]; }       ///< Gets the storage index of the first cover of a sensor.
+  uint32_t CoverEnd(size_t sensor) const { return cover_offsets_[sensor + 1]; }     ///< Gets the storage index past the last cover of a sensor.
+  const std::vector<Cover> &GetInitialCovers() const { return initial_covers_; }    ///< Gets the records of all covers as generated.
+  const CsrGraph &GetSensorTargets() const { return sensor_targets_; }              ///< Gets the local targets of every sensor.
+  const CsrGraph &GetSensorSensors() const { return sensor_sensors_; }              ///< Gets the local sensors of every sensor.
+  const std::vector<uint32_t> &GetCoverOffsets() const { return cover_offsets_; }   ///< Gets the index of the first cover of each sensor.
+  const std::vector<uint32_t> &GetEdgeOffsets() const { return edge_offsets_; }     ///< Gets the offset of the first LDGraph edge of each cover.
+  const std::vector<Edge> &GetEdges() const { return edges_; }                      ///< Gets the LDGraph edges of all covers.
+  /**
+   * @brief Gets the local targets of a sensor.
+   * @param sensor The index of the sensor.
+   * @return Indices of the targets in range, sorted by position.
+   */
+  std::span<const uint32_t> LocalTargets(size_t sensor) const
+  {
+    auto [begin, end] = sensor_targets_.Neighbors(sensor);
+    return {begin, end};
+  }
+  /**
+   * @brief Gets the local sensors of a sensor.
+   * @param sensor The index of the sensor.
+   * @return Indices of the other sensors in range, sorted by position.
+   */
+  std::span<const uint32_t> LocalSensors(size_t sensor) const
+  {
+    auto [begin, end] = sensor_sensors_.Neighbors(sensor);
+    return {begin, end};
+  }
+  /**
+   * @brief Gets a member of a cover of a sensor.
+   * @param sensor The index of the sensor owning the cover.
+   * @param bit The position of the member in Cover::members.
+   * @return The index of the member: the local sensor at that position, or the sensor itself after the last one.
+   */
+  uint32_t MemberAt(size_t sensor, size_t bit) const
+  {
+    std::span<const uint32_t> local_sensors = LocalSensors(sensor);
+    return bit < local_sensors.size() ? local_sensors[bit] : static_cast<uint32_t>(sensor);
+  }
+  /**
+   * @brief Gets the bit standing for a sensor itself in the members of its covers.
+   * @param sensor The index of the sensor.
+   * @return The mask with only that bit set.
+   */
+  bit_vec SelfBit(size_t sensor) const { return bit_vec{1} << LocalSensors(sensor).size(); }
+  /**
+   * @brief Gets the LDGraph edges of a cover.
+   * @param cover The storage index of the cover.
+   * @return Edges to other covers of the same sensor.
+   */
+  std::span<const Edge> Edges(uint32_t cover) const
+  {
+    return {edges_.data() + edge_offsets_[cover], edges_.data() + edge_offsets_[cover + 1]};
+  }
+};
@@ -2,6 +2,8 @@
 #include <limits>
 #include <vector>
 #include <unordered_map>
+#include <memory_resource>
+#include <span>
 
 #include "core/cover_structures.hpp"
 #include "core/Sensor.hpp"
@@ -15,59 +17,64 @@
  * @brief Generates a Localized Distributed Graph (LDGraph) for a set of sensors and targets.
  * @details The LDGraphGenerator class takes a set of sensors and targets, generates sensor cover masks, minimal cover masks,
  * and constructs the LDGraph based on the relationships between sensors and targets.
+ * Covers and edges are appended straight to a LocalCovers batch. Temporary data is taken from a memory resource,
+ * so generating the covers of many sensors in a row reuses the same memory instead of going to the heap.
  */
 class LDGraphGenerator
 {
-  std::vector<Sensor *> sensors_;           ///< List of sensors considered.
-  std::vector<Target *> targets_;           ///< List of targets considered.
-  size_t sensor_num_;                       ///< Number of sensors.
-  size_t target_num_;                       ///< Number of targets.
-  std::vector<bit_vec> sensor_cover_masks_; ///< Masks representing which sensors cover which targets.
-  std::vector<bit_vec> cover_masks_;        ///< Masks representing minimal covers.
-  std::vector<Cover> covers_;               ///< List of covers generated.
-  LDGraph graph_;                           ///< Graph representing the relationships between sensors and covers.
-  bit_vec full_cover;                       ///< Bitmask representing a full cover (all targets covered).
-  bit_vec full_sensor;                      ///< Bitmask representing a full set of sensors (all sensors considered).
+  std::span<const uint32_t> sensors_;           ///< Indices of the sensors considered.
+  std::span<const Sensor> all_sensors_;         ///< All sensors of the simulation, looked up by index.
+  size_t sensor_num_;                           ///< Number of sensors.
+  size_t target_num_;                           ///< Number of targets.
+  std::span<const bit_vec> sensor_cover_masks_; ///< Masks representing which sensors cover which targets.
+  std::pmr::memory_resource *scratch_;          ///< Resource for temporary data, released by the caller.
+  bit_vec full_cover;                           ///< Bitmask representing a full cover (all targets covered).
+  bit_vec full_sensor;                          ///< Bitmask representing a full set of sensors (all sensors considered).
 
 public:
   /**
    * @brief Constructs an LDGraphGenerator with a set of sensors and targets.
-   * @param sensors A vector of pointers to Sensor objects.
-   * @param targets A vector of pointers to Target objects.
+   * @param sensors Indices of the sensors considered.
+   * @param all_sensors All sensors of the simulation, providing ids and battery levels.
+   * @param target_num The number of targets considered.
+   * @param sensor_cover_masks Masks of targets covered by each sensor, in the same order as sensors.
+   * @param scratch Resource for temporary data. All arguments must outlive the generator.
    */
-  LDGraphGenerator(std::vector<Sensor *> &sensors, std::vector<Target *> &targets);
-  std::pair<std::vector<Cover>, LDGraph> operator()(); ///< Generates the LDGraph and covers based on the provided sensors and targets.
+  LDGraphGenerator(std::span<const uint32_t> sensors, std::span<const Sensor> all_sensors, size_t target_num, std::span<const bit_vec> sensor_cover_masks,
+                   std::pmr::memory_resource *scratch = std::pmr::get_default_resource());
+  /**
+   * @brief Generates the LDGraph and covers based on the provided sensors and targets.
+   * @param out The batch receiving the covers as the next sensor. Member bits follow the order of sensors.
+   */
+  void operator()(LocalCovers &out);
 
 private:
   /**
-   * @brief Converts a bitmask to a vector of Sensor pointers.
+   * @brief Gets the lowest battery level among the sensors of a mask.
    * @param mask The bitmask representing the sensors.
-   * @return A vector of pointers to the corresponding Sensor objects.
-   */
-  std::vector<Sensor *> MaskToSensors(bit_vec mask);
-  /**
-   * @brief Generates masks for sensors covering targets.
-   * Each mask represents which targets are covered by a specific sensor.
+   * @return The lowest battery level, or the maximum of uint16_t for an empty mask.
    */
-  void GenerateSensorCoverMasks();
+  uint16_t MinBatteryLevel(bit_vec mask) const;
   /**
    * @brief Generates minimal cover masks.
    * Each mask represents a minimal set of sensors that can cover all targets.
    * Minimal cover is defined as a set of sensors such that removing any sensor from the set would result in at least one target not being covered.
+   * @param cover_masks Receives the masks.
    */
-  void GenerateMinimalCoverMasks();
-  /**
-   * @brief Initializes cover data for the sensors.
-   */
-  void InitializeCoverData();
+  void GenerateMinimalCoverMasks(std::pmr::vector<bit_vec> &cover_masks);
   /**
    * @brief Generates the Localized Distributed Graph (LDGraph).
    * The graph is constructed based on interactions of covers (as a sets of sensors) with each other.
+   * Edges are written in two passes, counting first, so every cover's edges are contiguous without per-cover lists.
+   * @param cover_masks The masks of the covers of the sensor.
+   * @param out The batch receiving the edges.
    */
-  void GenerateLDGraph();
+  void GenerateLDGraph(std::span<const bit_vec> cover_masks, LocalCovers &out);
   /**
    * @brief Generates cover data for the sensors.
    * @details This method sets attributes of covers. This is caused by the fact that some of them depends on LDGraph structure.
+   * @param covers The records of the covers of the sensor, members already set.
+   * @param out The batch holding the edges of the covers.
    */
-  void GenerateCoverData();
+  void GenerateCoverData(std::span<Cover> covers, const LocalCovers &out);
 };
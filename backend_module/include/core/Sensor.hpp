@@ -1,28 +1,53 @@
 #pragma once
 #include <vector>
-#include <unordered_set>
+#include <span>
 #include <optional>
 #include <ranges>
 #include <algorithm>
 #include <stdexcept>
 #include <format>
+#include <memory_resource>
 
 #include "shared/utility.hpp"
 #include "core/Entity.hpp"
 #include "core/Target.hpp"
 #include "core/utility.hpp"
 #include "core/cover_structures.hpp"
+#include "core/CoverStorage.hpp"
 /**
  * @file Sensor.hpp
  * @brief Defines the Sensor class, which represents a sensor in the system.
  */
 
+class Sensor;
+
+/**
+ * @struct NetworkView
+ * @brief The arrays of a simulation that sensors refer to by index.
+ * @details Sensors hold no pointers, only their runtime state; everything else is reached through this view,
+ * so a simulation can be copied or moved without fixing up references.
+ */
+struct NetworkView
+{
+  std::span<Sensor> sensors;   ///< All sensors of the simulation.
+  std::span<Target> targets;   ///< All targets of the simulation.
+  std::span<Cover> covers;     ///< Runtime records of all covers, each sensor's covers in the range given by storage.
+  const CoverStorage *storage; ///< Neighborhoods and cover members, shared by copies of the simulation.
+
+  /**
+   * @brief Gets the live cover records of a sensor, those without dead members.
+   * @param sensor The index of the sensor.
+   * @return The records, in the order of the last reshuffle. Pruned records follow them in covers.
+   */
+  std::span<Cover> CoversOf(size_t sensor) const;
+};
+
 /**
  * @class Sensor
  * @brief Represents a sensor in the system.
  * @details The Sensor class inherits from Entity and Id<Sensor>.
- * It represents a sensor with a position, battery level, state,
- * and local targets and sensors. It also manages covers and their reshuffling.
+ * It represents a sensor with a position, battery level and state. Its local targets, local sensors and covers
+ * are reached by its index through a NetworkView, and it manages the reshuffling of its covers.
  */
 class Sensor : public Entity, public Id<Sensor>
 {
@@ -36,57 +61,73 @@ public:
   };
 
 private:
-  inline static double Radius;          ///< The sensing radius of the sensor
-  uint16_t battery_lvl_;                ///< The battery level of the sensor
-  State state_;                         ///< The current state of the sensor
-  std::vector<Target *> local_targets_; ///< List of local targets that the sensor can detect
-  std::vector<Sensor *> local_sensors_; ///< List of local sensors that the sensor can communicate with
-  LDGraph local_graph_;                 ///< LDGraph representing possible coverages and relationships between them
-  std::vector<Cover> covers_;           ///< List of minimal covers visible to the sensor
-  Cover *current_cover_;                ///< Pointer to the current best cover
-  size_t current_cover_idx_;            ///< Index of the current cover in the covers list
+  uint16_t battery_lvl_;       ///< The battery level of the sensor
+  State state_;                ///< The current state of the sensor
+  uint32_t current_cover_idx_; ///< Index of the current cover among the covers of the sensor
+  uint32_t live_cover_num_;    ///< Number of covers without dead members; they come first among the covers of the sensor
+  bit_vec dead_members_;       ///< Bits of Cover::members standing for dead sensors, whose covers have been pruned
 
 public:
   /**
    * @brief Constructs a Sensor with a given position and battery level.
    * @param position The initial position of the sensor.
    * @param battery_lvl The initial battery level of the sensor.
+   * @param id The id of the sensor, see SimulationContext::NextSensorId.
    */
-  Sensor(Point position, uint32_t battery_lvl) : Entity(position), Id<Sensor>(), battery_lvl_(battery_lvl), state_(State::kUndecided) {}
+  Sensor(Point position, uint32_t battery_lvl, Id<Sensor> id) : Entity(position), Id<Sensor>(id), battery_lvl_(battery_lvl), state_(State::kUndecided), current_cover_idx_(0), live_cover_num_(0), dead_members_(0) {}
   Sensor(const Sensor &other) = default; ///< Copy constructor for Sensor.
   /**
    * @brief Initializes the sensor.
-   * @details This method creates a local graph for the sensor and initializes its covers.
+   * @details This method creates a local graph for the sensor and generates its covers.
+   * @param idx The index of the sensor.
+   * @param network The simulation; its storage must hold the neighborhoods, covers are not needed yet.
+   * @param sensor_cover_masks For each local sensor followed by this sensor, the mask of local targets it covers.
+   * Bit k of a mask stands for the k-th local target. The masks are ignored if the sensor has no local targets.
+   * @param out The batch receiving the generated covers as its next sensor, none if the sensor has no local targets.
+   * @param scratch Resource for temporary data of the generation.
    * @exception Throws std::runtime_error if number of targets or sensors is greater than bit_vec_size.
    */
-  void Initialize();
-  inline static void SetRadius(double radius) { Radius = radius; }           ///< Sets the sensing radius of the sensor.
-  inline static double GetRadius() { return Radius; }                        ///< Gets the sensing radius of the sensor.
-  inline State GetState() const { return state_; }                           ///< Gets the current state of the sensor.
-  inline uint16_t GetBatteryLevel() const { return battery_lvl_; }           ///< Gets the battery level of the sensor.
-  inline std::vector<Target *> &GetLocalTargets() { return local_targets_; } ///< Gets the list of local targets that the sensor can detect.
+  void Initialize(uint32_t idx, const NetworkView &network, std::span<const bit_vec> sensor_cover_masks, LocalCovers &out,
+                  std::pmr::memory_resource *scratch = std::pmr::get_default_resource());
+  inline State GetState() const { return state_; }                     ///< Gets the current state of the sensor.
+  inline uint16_t GetBatteryLevel() const { return battery_lvl_; }     ///< Gets the battery level of the sensor.
+  inline void SetState(State state) { state_ = state; }                ///< Sets the current state of the sensor.
+  inline uint32_t GetCoverIndex() const { return current_cover_idx_; } ///< Gets the index of the current cover among the covers of the sensor.
+  inline uint32_t GetLiveCoverNum() const { return live_cover_num_; }  ///< Gets the number of covers not pruned yet.
   /**
-   * @brief Checks if a target is a local target.
-   * @param target The target to check.
-   * @return True if the target is local, false otherwise.
+   * @brief Resets the sensor to the state it starts a run in, with a new battery level.
+   * @param battery_lvl The initial battery level.
+   * @param has_targets Whether the sensor has local targets; sensors without any are dead from the start.
+   * @param cover_num The number of covers of the sensor, all of them live.
    */
-  inline bool IsLocalTarget(Target &target) const { return std::ranges::find(local_targets_, &target) != local_targets_.end(); }
-  inline void SetState(State state) { state_ = state; } ///< Sets the current state of the sensor.
+  void ResetRuntime(uint32_t battery_lvl, bool has_targets, uint32_t cover_num);
   /**
-   * @brief Adds a local target to the sensor.
-   * @param target The target to add.
+   * @brief Restores the runtime state of the sensor, e.g. from a checkpoint.
+   * @param battery_lvl The battery level.
+   * @param state The state.
+   * @param cover_idx The index of the current cover among the covers of the sensor.
    */
-  inline void AddLocalTarget(Target &target) { local_targets_.emplace_back(&target); }
+  void RestoreRuntime(uint16_t battery_lvl, State state, uint32_t cover_idx)
+  {
+    battery_lvl_ = battery_lvl;
+    state_ = state;
+    current_cover_idx_ = cover_idx;
+  }
   /**
-   * @brief Adds a local sensor to the sensor.
-   * @param sensor The sensor to add.
+   * @brief Derives which covers are pruned from the states of the local sensors, after RestoreRuntime.
+   * @param idx The index of the sensor.
+   * @param network The simulation, with the states of all sensors and the cover records restored.
+   * @return false if the live covers do not precede the pruned ones, i.e. the records were not produced by PruneCovers.
    */
-  inline void AddLocalSensor(Sensor &sensor) { local_sensors_.emplace_back(&sensor); }
+  bool RestorePruning(uint32_t idx, const NetworkView &network);
   /**
    * @brief Updates the sensor's state.
+   * @param idx The index of the sensor.
+   * @param network The simulation; targets covered by the sensor are flagged.
+   * @return true if the battery ran out during this tick, false otherwise.
    * @note this should be called every tick of the simulation.
    */
-  void Update();
+  bool Update(uint32_t idx, const NetworkView &network);
   /**
    * @brief Begins the reshuffle process for the sensor.
    * @note This should be called before calling Reshuffle().
@@ -95,13 +136,35 @@ public:
   /**
    * @brief Chooses the best cover for the sensor and sets the sensor's state accordingly.
    * @details This method selects the best cover based on the current local graph and updates the sensor's state.
+   * @param idx The index of the sensor.
+   * @param network The simulation the sensor belongs to.
+   */
+  bool Reshuffle(uint32_t idx, const NetworkView &network);
+  /**
+   * @brief Drops the covers containing a local sensor that just died.
+   * @details Such covers can never become feasible again. They are moved behind the live ones, where Reshuffle
+   * no longer scans them, and their LDGraph edge weights are subtracted from the degrees of the live covers.
+   * A sensor that died itself drops all of its covers. Called once per death, for the dead sensor and each of its local sensors.
+   * @param idx The index of the sensor.
+   * @param dead The index of the sensor that died.
+   * @param edge_weight The weight of every LDGraph edge in this run. All sensors start with the same battery level,
+   * which is then the weight of every edge; a fork may change it, so the weights in storage are not used.
+   * @param network The simulation the sensor belongs to.
    */
-  bool Reshuffle();
+  void PruneCovers(uint32_t idx, uint32_t dead, uint16_t edge_weight, const NetworkView &network);
 
 private:
   /**
    * @brief Updates the local graph of the sensor.
-   * @details This method updates the local graph based on the current local targets and sensors.
+   * @details This method updates the runtime data of the covers from the current states of their members.
+   * @param idx The index of the sensor.
+   * @param covers The cover records of the sensor.
+   * @param network The simulation the sensor belongs to.
    */
-  void UpdateCoverData();
-};
\ No newline at end of file
+  void UpdateCoverData(uint32_t idx, std::span<Cover> covers, const NetworkView &network);
+};
+
+inline std::span<Cover> NetworkView::CoversOf(size_t sensor) const
+{
+  return covers.subspan(storage->CoverBegin(sensor), sensors[sensor].GetLiveCoverNum());
+}
@@ -1,11 +1,17 @@
 #pragma once
 #include <vector>
+#include <memory>
 #include <algorithm>
 #include <random>
 #include <stdexcept>
 // #include <iostream> //for debug
 
 #include "core/Sensor.hpp"
+#include "core/SimulationContext.hpp"
+#include "core/space_filling_curve.hpp"
+#include "core/SpatialGrid.hpp"
+#include "core/parallel.hpp"
+#include "core/TaskControl.hpp"
 #include "shared/utility.hpp"
 #include "shared/simulation_structures.hpp"
 /**
@@ -13,6 +19,38 @@
  * @brief Contains the Simulation class that manages the simulation of sensor networks.
  */
 
+/**
+ * @struct SimulationLayout
+ * @brief The part of an initialized Simulation that depends only on the scenario, the sensor radius and the ordering.
+ * @details Together with the scenario it is everything Initialize computes, so storing it once is enough
+ * to restore any number of snapshots of runs of the same scenario.
+ */
+struct SimulationLayout
+{
+  double sensor_radius = 0.0;                  ///< The sensing radius of sensors.
+  std::vector<size_t> target_input_idx;        ///< Maps the internal index of a target to its index in the scenario.
+  std::vector<size_t> sensor_input_idx;        ///< Maps the internal index of a sensor to its index in the scenario.
+  std::shared_ptr<const CoverStorage> storage; ///< Neighborhoods and covers.
+};
+
+/**
+ * @struct SimulationSnapshot
+ * @brief The mutable runtime of a Simulation between two ticks.
+ * @details Arrays follow the internal order of sensors, targets and covers. Covers are kept in the order of the
+ * last reshuffle, which is part of the protocol: it decides which cover a sensor tries first.
+ */
+struct SimulationSnapshot
+{
+  uint32_t initial_battery_lvl = 0;    ///< The initial battery level of the sensors.
+  uint32_t reshuffle_interval = 0;     ///< The interval at which sensors are reshuffled.
+  uint32_t tick = -1;                  ///< The last tick, -1 before the first one.
+  std::vector<uint16_t> battery_lvls;  ///< The battery level of every sensor.
+  std::vector<Sensor::State> states;   ///< The state of every sensor.
+  std::vector<uint32_t> cover_indices; ///< The index of the current cover of every sensor among its covers.
+  std::vector<uint8_t> target_flags;   ///< The cover flag of every target.
+  std::vector<Cover> covers;           ///< The runtime records of all covers.
+};
+
 /**
  * @class Simulation
  * @brief Manages the simulation of sensor networks.
@@ -20,29 +58,101 @@
  */
 class Simulation
 {
-  uint32_t reshuffle_interval_;    ///< The interval at which sensors are reshuffled in the simulation.
-  uint32_t initial_battery_lvl_;   ///< The initial battery level of the sensors in the simulation.
-  uint32_t tick_;                  ///< The current tick of the simulation.
-  uint32_t covered_targets_count_; ///< The count of targets that are currently covered by sensors.
-  bool all_target_covered_;        ///< Indicates if all targets are covered by sensors.
-  std::vector<Target> targets_;    ///< List of targets in the simulation.
-  std::vector<Sensor> sensors_;    ///< List of sensors in the simulation.
-  size_t target_num;               ///< The number of targets in the simulation.
-  size_t sensor_num;               ///< The number of sensors in the simulation.
+  uint32_t reshuffle_interval_;                 ///< The interval at which sensors are reshuffled in the simulation.
+  uint32_t initial_battery_lvl_;                ///< The initial battery level of the sensors in the simulation.
+  uint32_t tick_;                               ///< The current tick of the simulation.
+  uint32_t covered_targets_count_;              ///< The count of targets that are currently covered by sensors.
+  bool all_target_covered_;                     ///< Indicates if all targets are covered by sensors.
+  uint32_t depleted_sensor_count_;              ///< The number of sensors that ran out of battery.
+  std::vector<Target> targets_;                 ///< List of targets in the simulation.
+  std::vector<Sensor> sensors_;                 ///< List of sensors in the simulation.
+  size_t target_num;                            ///< The number of targets in the simulation.
+  size_t sensor_num;                            ///< The number of sensors in the simulation.
+  std::vector<size_t> target_input_idx_;        ///< Maps the internal index of a target to its index in the scenario.
+  std::vector<size_t> sensor_input_idx_;        ///< Maps the internal index of a sensor to its index in the scenario.
+  SimulationContext context_;                   ///< Radius, id allocation and scratch memory of this simulation.
+  std::shared_ptr<const CoverStorage> storage_; ///< Neighborhoods and covers, shared with clones and forks.
+  std::vector<Cover> covers_;                   ///< Runtime records of all covers, each sensor's range kept in priority order.
 
 public:
-  Simulation() : tick_(-1), all_target_covered_(false), covered_targets_count_(0) {} ///< Default constructor initializes the simulation with default values.
+  Simulation() : tick_(-1), all_target_covered_(false), covered_targets_count_(0), depleted_sensor_count_(0) {} ///< Default constructor initializes the simulation with default values.
+  Simulation &operator=(const Simulation &) = delete;
+  Simulation(Simulation &&) = default;
+  Simulation &operator=(Simulation &&) = default;
   /**
    * @brief Constructs a Simulation with given parameters and scenario.
    * @param parameters The simulation parameters.
-   * @param scenario The simulation scenario containing target and sensor positions.
+   * @param scenario The target and sensor positions, e.g. a SimulationScenario. They are copied, so the view may end after the call.
+   * @param ordering The order in which sensors and targets are stored internally.
+   * @param control Optional progress and cancellation flag, updated while covers are generated.
+   * @exception Throws std::runtime_error if cancellation is requested through control,
+   * or if there are more sensors than cover records can identify (Cover::kMaxMinId + 1).
+   * @details Temporary buffers of the initialization live in the scratch arena of the simulation's context
+   * and are released at once when it completes.
+   * @note States are always reported in scenario order. Reshuffles visit sensors in the internal order,
+   * so a reordered simulation is an equally valid execution of the protocol, but not necessarily an identical one.
+   */
+  void Initialize(const SimulationParameters &parameters, ScenarioView scenario, SpatialOrdering ordering = SpatialOrdering::kInput, TaskControl *control = nullptr);
+  /**
+   * @brief Copies the simulation in its current state.
+   * @details Sensors, targets and covers refer to each other by index and the covers themselves live in a
+   * CoverStorage shared by both simulations, so only the runtime arrays are copied: O(sensors + targets + covers)
+   * plain data, without generating or copying any cover members or LDGraph edges.
+   * The clone continues exactly as the original would, which allows branching a run at any tick.
+   * @return The copy.
+   */
+  Simulation Clone() const;
+  /**
+   * @brief Creates a simulation of the same scenario with other runtime parameters, without generating covers again.
+   * @details Covers depend only on positions and the sensor radius, so any initialized simulation serves as a template:
+   * the fork is a Clone with batteries, states, cover records and the tick reset.
+   * The fork behaves exactly like a simulation initialized from scratch with the given parameters.
+   * @param parameters The parameters of the fork. Only initial_battery_lvl and reshuffle_interval are used here;
+   * stop condition and max ticks are up to the caller, as for Initialize.
+   * @return The forked simulation, ready to tick.
+   * @exception Throws std::runtime_error if the sensor radius differs.
+   */
+  Simulation Fork(const SimulationParameters &parameters) const;
+  /**
+   * @brief Gets the part of the simulation that Initialize derives from the scenario.
+   * @return The layout; its cover storage is shared with this simulation.
+   */
+  SimulationLayout GetLayout() const;
+  /**
+   * @brief Copies the mutable runtime of the simulation.
+   * @return The snapshot, which Restore turns back into a simulation continuing exactly like this one.
    */
-  void Initialize(const SimulationParameters &parameters, const SimulationScenario &scenario);
+  SimulationSnapshot TakeSnapshot() const;
+  /**
+   * @brief Rebuilds a simulation from its layout and a snapshot, without generating covers.
+   * @param scenario The scenario the layout was computed for.
+   * @param layout The layout, see GetLayout.
+   * @param snapshot The runtime, see TakeSnapshot.
+   * @return The simulation, continuing from the tick of the snapshot.
+   * @exception Throws std::runtime_error if scenario, layout and snapshot do not fit together.
+   */
+  static Simulation Restore(ScenarioView scenario, SimulationLayout layout, const SimulationSnapshot &snapshot);
   /**
    * @brief Gets the current state of the simulation.
    * @return A SimulationState object containing the current state of the simulation.
    */
   SimulationState GetSimulationState();
+  /**
+   * @brief Writes the current state of the simulation into an existing state.
+   * @details The vectors of the state are resized, not reallocated, so refilling the same state every tick
+   * allocates nothing once its buffers have grown to the size of the simulation.
+   * @param state The state to overwrite.
+   */
+  void FillSimulationState(SimulationState &state);
+  uint32_t GetTick() const { return tick_; }                                  ///< Gets the last tick, -1 before the first one.
+  size_t GetTargetNum() const { return target_num; }                          ///< Gets the number of targets.
+  uint32_t GetDepletedSensorCount() const { return depleted_sensor_count_; } ///< Gets the number of sensors that ran out of battery.
+  /**
+   * @brief Counts the targets covered in the last tick, without building a state.
+   * @details Updates the same counters as GetSimulationState and allocates nothing.
+   * @return The number of covered targets.
+   */
+  uint32_t CountCoveredTargets();
   /**
    * @brief Advances the simulation by one tick.
    * @details This method updates the state of sensors and targets, reshuffles sensors if necessary, and counts coverage.
@@ -51,27 +161,78 @@ public:
   void Tick();
 
 private:
+  Simulation(const Simulation &) = default; ///< Copies share the cover storage; see Clone.
+  /**
+   * @brief Gets the arrays sensors refer to.
+   * @return A view of this simulation.
+   */
+  NetworkView View() { return {sensors_, targets_, covers_, storage_.get()}; }
   /**
    * @brief Initializes Targets and Sensors at specified positions.
    * @param target_positions The positions of targets in the simulation.
    * @param sensor_positions The positions of sensors in the simulation.
    */
-  void PlaceAtPositions(const std::vector<Point> &target_positions, const std::vector<Point> &sensor_positions);
+  void PlaceAtPositions(std::span<const Point> target_positions, std::span<const Point> sensor_positions);
+  /**
+   * @brief Reorders targets and sensors along a space-filling curve.
+   * @details Entities keep their ids, so cover priorities are unaffected.
+   * Neighbors end up close to each other, which makes dereferencing local sensors and targets cache friendly.
+   * @param ordering The curve used for reordering. SpatialOrdering::kInput keeps the scenario order.
+   */
+  void RenumberAlongCurve(SpatialOrdering ordering);
+  /**
+   * @brief Reorders entities so that entity i becomes the one at position input_idx[i].
+   * @param entities The entities to reorder.
+   * @param input_idx The new order.
+   */
+  template <typename T>
+  static void ApplyOrder(std::vector<T> &entities, const std::vector<size_t> &input_idx)
+  {
+    std::vector<T> reordered;
+    reordered.reserve(entities.size());
+    for (size_t idx : input_idx)
+    {
+      reordered.emplace_back(std::move(entities[idx]));
+    }
+    entities = std::move(reordered);
+  }
   /**
    * @brief Sorts indexes of targets and sensors by their positions.
    * @param target_idx A vector to hold the indices of targets.
    * @param sensor_idx A vector to hold the indices of sensors.
    */
-  void SortByPositions(std::vector<size_t> &target_idx, std::vector<size_t> &sensor_idx);
+  void SortByPositions(std::pmr::vector<size_t> &target_idx, std::pmr::vector<size_t> &sensor_idx);
   /**
    * @brief Determines the neighborhoods of sensors and targets.
-   * @param targets_idx A vector holding the indices of targets.
-   * @param sensors_idx A vector holding the indices of sensors.
+   * @details Radius queries are answered by a SpatialGrid, so the whole pass is near-linear in the number of entities.
+   * Queries run in parallel; each thread gathers its own edge list and the lists are merged into CsrGraph adjacency,
+   * which becomes part of the CoverStorage.
+   * @param targets_idx A vector holding the indices of targets, sorted by position.
+   * @param sensors_idx A vector holding the indices of sensors, sorted by position.
+   * @param sensor_targets Output graph holding the local targets of every sensor.
+   * @param sensor_sensors Output graph holding the local sensors of every sensor.
    */
-  void DetermineNeighborhoods(std::vector<size_t> &targets_idx, std::vector<size_t> &sensors_idx);
+  void DetermineNeighborhoods(std::pmr::vector<size_t> &targets_idx, std::pmr::vector<size_t> &sensors_idx, CsrGraph &sensor_targets, CsrGraph &sensor_sensors);
+  /**
+   * @brief Initializes all sensors, generating their covers.
+   * @details The local coverage masks are built straight from the adjacency graphs:
+   * local targets of a sensor are numbered once, and the targets of every local sensor are translated
+   * to bits through that numbering. Sensors are independent of each other, so they are initialized in parallel;
+   * their covers are then appended to the storage in sensor order.
+   * @param storage The storage holding the neighborhoods, receiving the covers.
+   * @param control Optional progress and cancellation flag.
+   * @exception Throws std::runtime_error if any sensor has too many targets or sensors in range, or on cancellation.
+   */
+  void InitializeSensors(CoverStorage &storage, TaskControl *control);
   /**
    * @brief Counts the coverage of targets by sensors and updates all_target_covered_ flag.
-   * @return A vector of booleans indicating whether each target is covered.
+   * @param is_target_covered Receives for each target, in input order, whether it is covered.
+   */
+  void CountCover(std::vector<bool> &is_target_covered);
+  /**
+   * @brief Prunes the covers a sensor that just died belonged to.
+   * @details Its own covers and those of its local sensors containing it are dropped from further reshuffles.
+   * @param dead The index of the sensor.
    */
-  std::vector<bool> CountCover();
+  void PruneDeadCovers(uint32_t dead);
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+#include "core/Sensor.hpp"
+#include "core/Target.hpp"
+/**
+ * @file SimulationContext.hpp
+ * @brief Contains the SimulationContext class holding the state shared by the entities of one simulation.
+ */
+
+/**
+ * @class SimulationContext
+ * @brief State shared by all entities of a single simulation.
+ * @details Holds what used to be process-wide: the sensing radius and the counters assigning entity ids.
+ * Every Simulation owns its own context, so any number of simulations can be initialized and run concurrently.
+ * The context also provides a scratch arena for temporary buffers of the initialization,
+ * which are released together instead of one by one.
+ * @note A context is used by one thread at a time, like the Simulation owning it.
+ */
+class SimulationContext
+{
+  double sensor_radius_ = 0.0;                                  ///< The sensing radius of sensors.
+  Id<Sensor>::id_t next_sensor_id_ = 0;                         ///< The id of the next created sensor.
+  Id<Target>::id_t next_target_id_ = 0;                         ///< The id of the next created target.
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> scratch_ ///< Arena for temporary buffers, boxed so the context stays movable.
+      = std::make_unique<std::pmr::monotonic_buffer_resource>();
+
+public:
+  SimulationContext() = default;
+  /**
+   * @brief Copies the radius and the id counters. The copy gets its own, empty scratch arena.
+   * @param other The context to copy.
+   */
+  SimulationContext(const SimulationContext &other)
+      : sensor_radius_(other.sensor_radius_), next_sensor_id_(other.next_sensor_id_), next_target_id_(other.next_target_id_) {}
+  SimulationContext(SimulationContext &&other) = default;
+  /**
+   * @brief Copies the radius and the id counters, keeping the own scratch arena.
+   * @param other The context to copy.
+   * @return This context.
+   */
+  SimulationContext &operator=(const SimulationContext &other)
+  {
+    sensor_radius_ = other.sensor_radius_;
+    next_sensor_id_ = other.next_sensor_id_;
+    next_target_id_ = other.next_target_id_;
+    return *this;
+  }
+  SimulationContext &operator=(SimulationContext &&other) = default;
+  double GetSensorRadius() const { return sensor_radius_; }            ///< Gets the sensing radius of sensors.
+  void SetSensorRadius(double radius) { sensor_radius_ = radius; }     ///< Sets the sensing radius of sensors.
+  Id<Sensor> NextSensorId() { return Id<Sensor>(next_sensor_id_++); } ///< Allocates the id of a new sensor.
+  Id<Target> NextTargetId() { return Id<Target>(next_target_id_++); } ///< Allocates the id of a new target.
+  /**
+   * @brief Gets the scratch arena.
+   * @details Allocations from the arena are never freed individually; memory is reclaimed by ReleaseScratch.
+   * @return The memory resource to pass to std::pmr containers.
+   */
+  std::pmr::memory_resource *GetScratch() { return scratch_.get(); }
+  /**
+   * @brief Frees all memory of the scratch arena.
+   * @note No container allocated from the arena may be used afterwards.
+   */
+  void ReleaseScratch() { scratch_->release(); }
+};
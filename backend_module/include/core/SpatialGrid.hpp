@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <bit>
+#include <utility>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "shared/utility.hpp"
+#include "core/utility.hpp"
+/**
+ * @file SpatialGrid.hpp
+ * @brief Defines the SpatialGrid class, a uniform grid answering fixed-radius neighbor queries,
+ * and the CsrGraph structure holding neighborhoods found with it.
+ */
+
+/**
+ * @struct CsrGraph
+ * @brief Adjacency lists stored in compressed sparse row form.
+ * @details Neighbors of vertex v are indices[offsets[v]] ... indices[offsets[v + 1] - 1].
+ */
+struct CsrGraph
+{
+  using EdgeList = std::vector<std::pair<uint32_t, uint32_t>>; ///< List of (vertex, neighbor) pairs
+
+  std::vector<uint32_t> offsets; ///< Offset of the first neighbor of each vertex, followed by the total edge count.
+  std::vector<uint32_t> indices; ///< Neighbors of all vertices, grouped by vertex.
+
+  /**
+   * @brief Builds the graph from edge lists gathered independently, e.g. by separate threads.
+   * @details Neighbors of a vertex keep the order in which they appear in the lists, with lists taken in order.
+   * @param vertex_num The number of vertices.
+   * @param edge_lists The edge lists to merge.
+   * @return The merged graph.
+   */
+  static CsrGraph FromEdgeLists(size_t vertex_num, const std::vector<EdgeList> &edge_lists)
+  {
+    CsrGraph graph;
+    graph.offsets.assign(vertex_num + 1, 0);
+    for (const EdgeList &edges : edge_lists)
+    {
+      for (const auto &[v, _] : edges)
+      {
+        ++graph.offsets[v + 1];
+      }
+    }
+    for (size_t v = 1; v <= vertex_num; ++v)
+    {
+      graph.offsets[v] += graph.offsets[v - 1];
+    }
+    graph.indices.resize(graph.offsets.back());
+    std::vector<uint32_t> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (const EdgeList &edges : edge_lists)
+    {
+      for (const auto &[v, u] : edges)
+      {
+        graph.indices[fill[v]++] = u;
+      }
+    }
+    return graph;
+  }
+  /**
+   * @brief Gets the neighbors of a vertex.
+   * @param v The vertex.
+   * @return Pair of pointers delimiting the neighbors.
+   */
+  std::pair<const uint32_t *, const uint32_t *> Neighbors(size_t v) const
+  {
+    return {indices.data() + offsets[v], indices.data() + offsets[v + 1]};
+  }
+};
+
+/**
+ * @class SpatialGrid
+ * @brief Uniform grid over a set of points, used to find all points within a fixed radius.
+ * @details Points are bucketed into square cells with side at least equal to the query radius,
+ * so every point within the radius of a query lies in the 3x3 block of cells around the query.
+ * Buckets are stored contiguously (counting sort), which keeps the grid build linear in the number of points.
+ * Coordinates are kept as separate x and y arrays, so candidates are tested in batches
+ * (four at a time with AVX2 when the module is built with WSN_ENABLE_AVX2).
+ * @note Queries only read the grid, so they can be issued from many threads at once.
+ */
+class SpatialGrid
+{
+  Point min_;                        ///< Lower-left corner of the grid.
+  double radius_;                    ///< Query radius.
+  double cell_size_;                 ///< Side of a single cell, not smaller than the radius.
+  int64_t nx_;                       ///< Number of cells along the x axis.
+  int64_t ny_;                       ///< Number of cells along the y axis.
+  std::vector<uint32_t> cell_start_; ///< Offset of the first item of each cell in items_, followed by the total item count.
+  std::vector<uint32_t> items_;      ///< Indices of points, grouped by cell.
+  std::vector<double> xs_;           ///< X coordinates of points, in the same order as items_.
+  std::vector<double> ys_;           ///< Y coordinates of points, in the same order as items_.
+
+public:
+  /**
+   * @brief Builds the grid over the given points.
+   * @param points The positions of points to index.
+   * @param radius The radius of subsequent queries.
+   */
+  SpatialGrid(std::span<const Point> points, double radius);
+  /**
+   * @brief Calls a function for each indexed point strictly closer to a position than the radius.
+   * @param position The query position. It does not need to lie inside the grid.
+   * @param f Function called with the index of every point in range.
+   */
+  template <typename F>
+  void ForEachInRadius(const Point &position, F &&f) const
+  {
+    int64_t cx = CellCoord(position.x - min_.x);
+    int64_t cy = CellCoord(position.y - min_.y);
+    int64_t x_lo = std::max<int64_t>(cx - 1, 0), x_hi = std::min<int64_t>(cx + 1, nx_ - 1);
+    int64_t y_lo = std::max<int64_t>(cy - 1, 0), y_hi = std::min<int64_t>(cy + 1, ny_ - 1);
+    if (x_lo > x_hi || y_lo > y_hi)
+    {
+      return;
+    }
+    for (int64_t y = y_lo; y <= y_hi; ++y)
+    {
+      // cells of a row are adjacent, so the row segment is a single contiguous range
+      TestRange(cell_start_[y * nx_ + x_lo], cell_start_[y * nx_ + x_hi + 1], position, f);
+    }
+  }
+
+private:
+  /**
+   * @brief Converts an offset from the grid corner to a cell coordinate.
+   * @param offset The offset along one axis.
+   * @return The cell coordinate, possibly outside of the grid.
+   */
+  int64_t CellCoord(double offset) const { return static_cast<int64_t>(std::floor(offset / cell_size_)); }
+  /**
+   * @brief Tests a contiguous range of candidates against the query position.
+   * @param begin The first candidate.
+   * @param end One past the last candidate.
+   * @param position The query position.
+   * @param f Function called with the index of every candidate in range.
+   */
+  template <typename F>
+  void TestRange(size_t begin, size_t end, const Point &position, F &f) const
+  {
+    const double r2 = Sqr(radius_);
+    size_t k = begin;
+#if defined(__AVX2__)
+    const __m256d qx = _mm256_set1_pd(position.x);
+    const __m256d qy = _mm256_set1_pd(position.y);
+    const __m256d vr2 = _mm256_set1_pd(r2);
+    for (; k + 4 <= end; k += 4)
+    {
+      __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs_.data() + k), qx);
+      __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys_.data() + k), qy);
+      __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+      unsigned mask = _mm256_movemask_pd(_mm256_cmp_pd(d2, vr2, _CMP_LT_OQ));
+      while (mask)
+      {
+        f(items_[k + std::countr_zero(mask)]);
+        mask &= mask - 1;
+      }
+    }
+#endif
+    for (; k < end; ++k)
+    {
+      if (Sqr(xs_[k] - position.x) + Sqr(ys_[k] - position.y) < r2)
+      {
+        f(items_[k]);
+      }
+    }
+  }
+};
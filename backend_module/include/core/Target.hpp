@@ -16,8 +16,9 @@ public:
   /**
    * @brief Constructs a Target with a given position.
    * @param position The initial position of the target.
+   * @param id The id of the target, see SimulationContext::NextTargetId.
    */
-  explicit Target(Point position) : Entity(position), Id<Target>(), covered_flag_(false) {}
+  Target(Point position, Id<Target> id) : Entity(position), Id<Target>(id), covered_flag_(false) {}
   Target(const Target &other) = default;                 ///< Copy constructor for Target.
   void SetCoverFlag(bool flag) { covered_flag_ = flag; } ///< Sets the cover flag of the target.
   bool GetCoverFlag() const { return covered_flag_; }    ///< Gets the cover flag of the target.
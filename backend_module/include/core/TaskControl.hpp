@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <stdexcept>
+/**
+ * @file TaskControl.hpp
+ * @brief Contains the TaskControl class used to observe and cancel long running work from another thread.
+ */
+
+/**
+ * @class TaskControl
+ * @brief Progress and cancellation flag shared between a worker and its observers.
+ * @details The worker reports progress and polls for cancellation, observers read the progress and request cancellation.
+ * All methods are safe to call from any thread.
+ */
+class TaskControl
+{
+  std::atomic<float> progress_ = 0.0f;  ///< Fraction of the work done, between 0 and 1.
+  std::atomic<bool> cancelled_ = false; ///< Flag indicating whether cancellation was requested.
+
+public:
+  float GetProgress() const { return progress_.load(std::memory_order_relaxed); }            ///< Gets the fraction of the work done.
+  void SetProgress(float progress) { progress_.store(progress, std::memory_order_relaxed); } ///< Sets the fraction of the work done.
+  bool IsCancelled() const { return cancelled_.load(std::memory_order_relaxed); }            ///< Checks if cancellation was requested.
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }                       ///< Requests cancellation; the worker stops at its next check.
+  /**
+   * @brief Stops the worker if cancellation was requested.
+   * @exception Throws std::runtime_error if cancellation was requested.
+   */
+  void ThrowIfCancelled() const
+  {
+    if (IsCancelled())
+    {
+      throw std::runtime_error("Task cancelled");
+    }
+  }
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+#include "core/parallel.hpp"
+/**
+ * @file ThreadPool.hpp
+ * @brief Contains the ThreadPool class running independent jobs on a fixed set of threads.
+ */
+
+/**
+ * @class ThreadPool
+ * @brief Work-stealing pool of threads for many independent jobs of uneven length, e.g. whole simulations.
+ * @details Every worker owns a queue. Jobs submitted from outside are dealt to the queues in turn,
+ * jobs submitted by a job go to the queue of its worker. A worker takes the newest job of its own queue
+ * and, once that is empty, steals the oldest job of another queue, so long jobs do not hold up short ones queued behind them.
+ * Workers are SerialThread, so parallel loops inside jobs run on the worker alone.
+ */
+class ThreadPool
+{
+  /**
+   * @struct Queue
+   * @brief Jobs waiting for one worker.
+   */
+  struct Queue
+  {
+    std::mutex mutex;                       ///< Guards jobs.
+    std::deque<std::function<void()>> jobs; ///< The waiting jobs, oldest first.
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_; ///< One queue per worker.
+  std::vector<std::thread> workers_;           ///< The worker threads.
+  std::mutex mutex_;                           ///< Guards the counters below and error_.
+  std::condition_variable wake_;               ///< Signalled when a job is queued or the pool stops.
+  std::condition_variable idle_;               ///< Signalled when the last pending job finishes.
+  size_t queued_ = 0;                          ///< Number of queued jobs not yet claimed by a worker.
+  size_t pending_ = 0;                         ///< Number of submitted jobs not yet finished.
+  size_t next_queue_ = 0;                      ///< The queue receiving the next job submitted from outside.
+  bool stopping_ = false;                      ///< Flag telling idle workers to exit.
+  std::exception_ptr error_;                   ///< The first exception thrown by a job since the last Wait.
+
+public:
+  /**
+   * @brief Starts the workers.
+   * @param thread_num The number of workers, or 0 for HardwareThreads().
+   */
+  explicit ThreadPool(size_t thread_num = 0);
+  /**
+   * @brief Finishes all queued jobs and stops the workers.
+   */
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  size_t GetThreadNum() const { return workers_.size(); } ///< Gets the number of workers.
+  /**
+   * @brief Queues a job.
+   * @param job The job. It may submit further jobs to the same pool.
+   */
+  void Submit(std::function<void()> job);
+  /**
+   * @brief Blocks until all submitted jobs have finished.
+   * @exception Rethrows the first exception thrown by a job since the last call. The other jobs still run to completion.
+   */
+  void Wait();
+
+private:
+  /**
+   * @brief Runs jobs until the pool stops.
+   * @param idx The index of the worker and its queue.
+   */
+  void WorkerLoop(size_t idx);
+  /**
+   * @brief Takes a job, from the own queue first and from the other queues otherwise.
+   * @details Called only after claiming a queued job, so a job is always found.
+   * @param idx The index of the worker.
+   * @return The job.
+   */
+  std::function<void()> Take(size_t idx);
+};
@@ -7,8 +7,6 @@
  * @brief Defines the Cover structure and related types for the sensor network.
  */
 
-class Sensor;
-
 using bit_vec = uint32_t;
 
 constexpr static uint8_t bit_vec_size = 24;
@@ -18,47 +16,95 @@ constexpr static uint8_t bit_vec_size = 24;
  * @brief Represents a cover in the sensor network.
  * @details A cover consists of a set of sensors, its degree,
  * lifetime (duration it can remain active), remaining sensors to turn on,
- * and the minimum sensor ID in the cover.
+ * and the minimum sensor ID in the cover. Members are a mask over the local sensors of the sensor owning the cover,
+ * and the priority fields are packed into a single integer ordered like the priority, so the record takes 16 bytes
+ * and two covers are compared with one integer comparison.
+ *
+ * Layout of key, from the most significant bit: infeasible (1 bit), degree (16 bits), inverted lifetime (16 bits),
+ * remaining_to_on (5 bits), min_id (26 bits).
  */
 struct Cover
 {
-  std::vector<Sensor *> sensors; ///< List of sensors in the cover
-  uint16_t degree;               ///< Degree of the cover in LDGraph
-  uint16_t lifetime;             ///< Lifetime of the cover in ticks
-  uint16_t remaining_to_on;      ///< Number of sensors that need to be turned on
-  uint32_t min_id;               ///< Minimum sensor ID in the cover
-  bool feasible = true;          ///< Indicates if the cover is feasible
+  static constexpr uint32_t kMinIdBits = 26;                             ///< Width of min_id in the key.
+  static constexpr uint32_t kMaxMinId = (uint32_t{1} << kMinIdBits) - 1; ///< Largest sensor id a cover can hold.
+
+  uint64_t key = uint64_t{1} << 63; ///< Priority fields packed for comparison, see the accessors.
+  uint32_t storage_idx = 0;         ///< Index of the cover in CoverStorage, where its LDGraph edges are stored
+  bit_vec members = 0;              ///< Bit k stands for the k-th local sensor of the owning sensor, the bit after them for the sensor itself
+
+  Cover() = default;
+  /**
+   * @brief Constructs a cover from its fields.
+   * @param storage_idx Index of the cover in CoverStorage.
+   * @param members Mask of the members.
+   * @param feasible Indicates if the cover is feasible.
+   * @param degree Degree of the cover in LDGraph.
+   * @param lifetime Lifetime of the cover in ticks.
+   * @param remaining_to_on Number of sensors that need to be turned on, at most 31.
+   * @param min_id Minimum sensor ID in the cover, at most kMaxMinId.
+   */
+  Cover(uint32_t storage_idx, bit_vec members, bool feasible, uint16_t degree, uint16_t lifetime, uint16_t remaining_to_on, uint32_t min_id)
+      : key(Pack(feasible, degree, lifetime, remaining_to_on, min_id)), storage_idx(storage_idx), members(members) {}
+
+  bool IsFeasible() const { return !(key >> 63); }                                                ///< Indicates if the cover is feasible
+  uint16_t GetDegree() const { return static_cast<uint16_t>(key >> 47); }                         ///< Degree of the cover in LDGraph
+  uint16_t GetLifetime() const { return static_cast<uint16_t>(~(key >> 31)); }                    ///< Lifetime of the cover in ticks
+  uint16_t GetRemainingToOn() const { return static_cast<uint16_t>((key >> kMinIdBits) & 0x1f); } ///< Number of sensors that need to be turned on
+  uint32_t GetMinId() const { return static_cast<uint32_t>(key & kMaxMinId); }                    ///< Minimum sensor ID in the cover
+  /**
+   * @brief Sets the degree of the cover in LDGraph.
+   * @param degree The degree.
+   */
+  void SetDegree(uint16_t degree) { key = Pack(IsFeasible(), degree, GetLifetime(), GetRemainingToOn(), GetMinId()); }
+  /**
+   * @brief Sets the fields that follow from the states of the members.
+   * @param feasible Indicates if the cover is feasible.
+   * @param lifetime Lifetime of the cover in ticks.
+   * @param remaining_to_on Number of sensors that need to be turned on.
+   */
+  void SetRuntime(bool feasible, uint16_t lifetime, uint16_t remaining_to_on)
+  {
+    key = Pack(feasible, GetDegree(), lifetime, remaining_to_on, GetMinId());
+  }
 
   /**
    * @brief Less-than operator for comparing two covers.
    *
-   * This operator realizes a priority function for covers.
+   * This operator realizes a priority function for covers: feasible first, then lower degree, longer lifetime,
+   * fewer sensors to turn on and lower minimum id.
    *
    * @param other The other cover to compare against.
    * @return true if this cover has higher priority than the other cover,
    *         false otherwise.
    */
-  bool operator<(const Cover &other) const
-  {
-    if (feasible != other.feasible) return feasible > other.feasible;
-    if (degree != other.degree) return degree < other.degree;
-    if (lifetime != other.lifetime) return lifetime > other.lifetime;
-    if (remaining_to_on != other.remaining_to_on) return remaining_to_on < other.remaining_to_on;
-    return min_id < other.min_id;
-  }
+  bool operator<(const Cover &other) const { return key < other.key; }
+
   /**
-   * @brief Checks if a sensor is part of this cover.
-   *
-   * @param sensor Pointer to the sensor to check.
-   * @return true if the sensor is in the cover, false otherwise.
+   * @brief Packs the priority fields into a key.
+   * @return The key, smaller for covers of higher priority.
    */
-  bool Contains(Sensor *sensor) const
+  static constexpr uint64_t Pack(bool feasible, uint16_t degree, uint16_t lifetime, uint16_t remaining_to_on, uint32_t min_id)
   {
-    return std::ranges::find(sensors, sensor) != sensors.end();
+    return uint64_t{!feasible} << 63 | uint64_t{degree} << 47 | uint64_t{static_cast<uint16_t>(~lifetime)} << 31 |
+           uint64_t{remaining_to_on & 0x1fu} << kMinIdBits | (min_id & kMaxMinId);
   }
 };
+static_assert(sizeof(Cover) == 16, "Cover must stay 16 bytes");
+
+using Edge = std::pair<uint32_t, uint16_t>; ///< Edge in LDGraph of the form (cover_idx, weight)
 
-using Edge = std::pair<uint32_t, uint16_t>; ///< Pair in LDGraph of the form (cover_idx, weight)
-using Adjacent = std::vector<Edge>;         ///< List of edges (vertex ~ edges)
-using LDGraph = std::vector<Adjacent>;      ///< List of vertices in LDGraph, each vertex contains a list of edges
-                                            ///< This representation relies on covers stored in std::vector<Cover>
\ No newline at end of file
+/**
+ * @struct LocalCovers
+ * @brief Covers generated for consecutive sensors, before they are moved to CoverStorage.
+ * @details Laid out like CoverStorage, so a whole batch of sensors fills a handful of flat arrays
+ * instead of a few vectors per sensor and one per cover.
+ */
+struct LocalCovers
+{
+  std::vector<uint32_t> cover_offsets{0}; ///< Index of the first cover of each sensor, followed by the total cover count.
+  std::vector<Cover> covers;              ///< Records of the covers; storage_idx is assigned by CoverStorage.
+  std::vector<uint32_t> edge_offsets{0};  ///< Offset of the first LDGraph edge of each cover, followed by the total edge count.
+  std::vector<Edge> edges;                ///< LDGraph edges of all covers. The cover index of an edge is local to its sensor.
+
+  size_t GetSensorNum() const { return cover_offsets.size() - 1; } ///< Gets the number of sensors in the batch.
+};
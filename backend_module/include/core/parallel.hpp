@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <algorithm>
+/**
+ * @file parallel.hpp
+ * @brief Contains helpers for splitting loops across threads.
+ */
+
+/**
+ * @brief Gets the number of threads worth using for parallel loops.
+ * @return The number of hardware threads, at least 1.
+ */
+inline size_t HardwareThreads()
+{
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Flag marking threads that already run one of many independent jobs, e.g. workers of a ThreadPool.
+ * @details Loops on such threads are not split further, since all hardware threads are busy with other jobs anyway.
+ */
+inline thread_local bool SerialThread = false;
+
+/**
+ * @brief Gets the number of chunks a range should be split into.
+ * @param n The size of the range.
+ * @param min_chunk The smallest range worth handing to a separate thread.
+ * @return The number of chunks, between 1 and HardwareThreads(), or 1 on a SerialThread.
+ */
+inline size_t ChunkCount(size_t n, size_t min_chunk = 4096)
+{
+  if (SerialThread)
+  {
+    return 1;
+  }
+  return std::clamp<size_t>(n / std::max<size_t>(min_chunk, 1), 1, HardwareThreads());
+}
+
+/**
+ * @brief Splits the range [0, n) into contiguous chunks and processes them concurrently.
+ * @details Chunk k always precedes chunk k + 1 in the range, so results gathered per chunk can be merged in order.
+ * A single chunk is processed on the calling thread.
+ * @param n The size of the range.
+ * @param chunk_num The number of chunks, usually obtained from ChunkCount().
+ * @param f Function called as f(chunk_idx, begin, end) for every chunk.
+ * @throws Rethrows the first exception thrown by any chunk.
+ */
+template <typename F>
+void ParallelChunks(size_t n, size_t chunk_num, F &&f)
+{
+  if (chunk_num <= 1)
+  {
+    f(size_t{0}, size_t{0}, n);
+    return;
+  }
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(chunk_num);
+  threads.reserve(chunk_num);
+  for (size_t c = 0; c < chunk_num; ++c)
+  {
+    threads.emplace_back([&, c]()
+                         {
+                           try
+                           {
+                             f(c, n * c / chunk_num, n * (c + 1) / chunk_num);
+                           }
+                           catch (...)
+                           {
+                             errors[c] = std::current_exception();
+                           } });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+  for (auto &error : errors)
+  {
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
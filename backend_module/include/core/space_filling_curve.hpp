@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+#include "shared/utility.hpp"
+/**
+ * @file space_filling_curve.hpp
+ * @brief Contains functions mapping 2D points to positions on Morton (Z-order) and Hilbert curves.
+ * @details The keys are used to renumber sensors and targets so that entities close in space are also close in memory.
+ */
+
+/**
+ * @struct CurveGrid
+ * @brief Quantizes points from a bounding box to a 2^16 x 2^16 integer grid.
+ */
+struct CurveGrid
+{
+  constexpr static uint32_t resolution = 1u << 16; ///< Number of cells along each axis.
+
+  Point min;    ///< Lower-left corner of the bounding box.
+  double scale; ///< Factor mapping a coordinate offset to a cell index.
+
+  /**
+   * @brief Constructs a grid covering the bounding box of the given points.
+   * @param begin Iterator to the first point.
+   * @param end Iterator past the last point.
+   */
+  template <typename It>
+  CurveGrid(It begin, It end) : min(0.0, 0.0), scale(1.0)
+  {
+    if (begin == end)
+    {
+      return;
+    }
+    Point max = *begin;
+    min = *begin;
+    for (It it = begin; it != end; ++it)
+    {
+      min.x = std::min(min.x, it->x);
+      min.y = std::min(min.y, it->y);
+      max.x = std::max(max.x, it->x);
+      max.y = std::max(max.y, it->y);
+    }
+    double extent = std::max(max.x - min.x, max.y - min.y);
+    scale = extent > 0.0 ? (resolution - 1) / extent : 0.0;
+  }
+  /**
+   * @brief Maps a point to its cell coordinates.
+   * @param p The point to map.
+   * @return Pair of (x, y) cell indices in [0, resolution).
+   */
+  std::pair<uint32_t, uint32_t> Cell(const Point &p) const
+  {
+    return {static_cast<uint32_t>((p.x - min.x) * scale), static_cast<uint32_t>((p.y - min.y) * scale)};
+  }
+};
+
+/**
+ * @brief Spreads the lower 16 bits of a value so that there is a zero bit between each of them.
+ * @param v The value to spread.
+ * @return The spread value.
+ */
+inline uint32_t SpreadBits(uint32_t v)
+{
+  v &= 0x0000ffff;
+  v = (v | (v << 8)) & 0x00ff00ff;
+  v = (v | (v << 4)) & 0x0f0f0f0f;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+/**
+ * @brief Computes the position of a cell on the Morton (Z-order) curve.
+ * @param x The x cell index.
+ * @param y The y cell index.
+ * @return The Morton key of the cell.
+ */
+inline uint32_t MortonKey(uint32_t x, uint32_t y)
+{
+  return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+/**
+ * @brief Computes the position of a cell on the Hilbert curve.
+ * @details Iterative variant of the classic xy-to-d conversion, rotating the quadrant at every level.
+ * @param x The x cell index.
+ * @param y The y cell index.
+ * @return The Hilbert key of the cell.
+ */
+inline uint32_t HilbertKey(uint32_t x, uint32_t y)
+{
+  uint32_t d = 0;
+  for (uint32_t s = CurveGrid::resolution / 2; s > 0; s /= 2)
+  {
+    uint32_t rx = (x & s) > 0;
+    uint32_t ry = (y & s) > 0;
+    d += s * s * ((3 * rx) ^ ry);
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        x = CurveGrid::resolution - 1 - x;
+        y = CurveGrid::resolution - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
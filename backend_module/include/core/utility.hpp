@@ -8,7 +8,7 @@
 /**
  * @class Id
  * @brief A class that provides a unique identifier for objects of type T.
- * @details The Id class generates a unique identifier for each instance of T using a static counter.
+ * @details Ids are assigned by the SimulationContext creating the instance, so they are unique within one simulation.
  */
 template <typename T>
 class Id
@@ -17,14 +17,10 @@ public:
   using id_t = uint32_t;
 
 private:
-  inline static id_t Counter = 0; ///< Static counter to generate unique IDs
-  id_t id_;                       ///< Unique identifier for the instance of T
-
-protected:
-  Id() : id_(Counter++) {}
+  id_t id_; ///< Unique identifier for the instance of T
 
 public:
-  static uint32_t GetIdCounter() { return Counter; }                 ///< Returns the current value of the ID counter.
+  explicit Id(id_t id) : id_(id) {}                                  ///< Constructs an identifier with the given value.
   uint32_t GetId() const { return id_; }                             ///< Returns the unique ID of the instance.
   bool operator<(const Id<T> &other) { return id_ < other.GetId(); } ///< Less-than operator for comparing IDs.
 };
@@ -2,6 +2,8 @@
 #include <ostream>
 #include <cstdint>
 #include <vector>
+#include <limits>
+#include <span>
 #include "core/Sensor.hpp"
 #include "shared/utility.hpp"
 #include "api/json.hpp"
@@ -20,6 +22,13 @@ enum class SimulationStopCondition ///< The condition that determines when the s
   kAnyCoverageLost
 };
 
+enum class SpatialOrdering ///< The order in which sensors and targets are stored inside the simulation.
+{
+  kInput,
+  kMorton,
+  kHilbert
+};
+
 /**
  * @struct SimulationParameters
  * @brief Contains parameters for the simulation.
@@ -64,8 +73,35 @@ struct SimulationScenario
 
   SimulationScenario(std::vector<Point> target_positions,
                      std::vector<Point> sensor_positions)
+      : target_positions(std::move(target_positions)),
+        sensor_positions(std::move(sensor_positions)) {}
+};
+
+/**
+ * @struct ScenarioView
+ * @brief Non-owning view of the positions of a scenario.
+ * @details Lets a simulation be placed straight from positions stored elsewhere, e.g. in a memory mapped point file,
+ * without copying them into a SimulationScenario first.
+ */
+struct ScenarioView
+{
+  std::span<const Point> target_positions; ///< The positions of targets in the simulation.
+  std::span<const Point> sensor_positions; ///< The positions of sensors in the simulation.
+
+  ScenarioView() = default;
+
+  ScenarioView(std::span<const Point> target_positions,
+               std::span<const Point> sensor_positions)
       : target_positions(target_positions),
         sensor_positions(sensor_positions) {}
+
+  /**
+   * @brief Views the positions of a scenario.
+   * @param scenario The scenario, which must outlive the view.
+   */
+  ScenarioView(const SimulationScenario &scenario)
+      : target_positions(scenario.target_positions),
+        sensor_positions(scenario.sensor_positions) {}
 };
 
 
@@ -102,6 +138,24 @@ struct SimulationState
         sensor_battery_lvls(sensor_battery_lvls) {}
 };
 
+/**
+ * @struct RunSummary
+ * @brief Aggregate results of a run, maintained tick by tick without recording any state.
+ */
+struct RunSummary
+{
+  static constexpr uint32_t kNoDeath = std::numeric_limits<uint32_t>::max(); ///< Value of first_death_tick if no sensor ran out of battery.
+
+  uint32_t lifetime = 0;                ///< The tick of the last state, the same as the tick of the last recorded state would be.
+  uint32_t ticks_run = 0;               ///< The number of ticks advanced.
+  uint32_t first_death_tick = kNoDeath; ///< The first tick at which a sensor ran out of battery, or kNoDeath.
+  double coverage_integral = 0.0;       ///< The sum of coverage percentages over all ticks, i.e. covered target-ticks per target.
+  float min_coverage = 1.0f;            ///< The lowest coverage percentage of any tick.
+  float initial_coverage = 0.0f;        ///< The coverage percentage of the first tick.
+  float final_coverage = 0.0f;          ///< The coverage percentage of the last tick.
+  bool finished = false;                ///< Indicates if the run reached max ticks or its stop condition, false if it was cancelled.
+};
+
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Point, x, y)
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(SimulationParameters, sensor_radius, initial_battery_lvl, reshuffle_interval, max_ticks, stop_condition, stop_threshold)
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(SimulationScenario, sensor_positions, target_positions)
@@ -132,3 +186,11 @@ NLOHMANN_JSON_SERIALIZE_ENUM(
         {SimulationStopCondition::kCoverageBelowThreshold, "kCoverageBelowThreshold"},
         {SimulationStopCondition::kAnyCoverageLost, "kAnyCoverageLost"},
     })
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    SpatialOrdering,
+    {
+        {SpatialOrdering::kInput, "kInput"},
+        {SpatialOrdering::kMorton, "kMorton"},
+        {SpatialOrdering::kHilbert, "kHilbert"},
+    })
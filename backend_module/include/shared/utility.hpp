@@ -1,5 +1,8 @@
 #pragma once
 #include <ostream>
+#include <vector>
+#include <cstring>
+#include <type_traits>
 
 /**
  * @brief Represents a 2D point with x and y coordinates.
@@ -45,3 +48,23 @@ struct Point
     return os << "(" << p.x << ", " << p.y << ")";
   }
 };
+
+static_assert(sizeof(Point) == 2 * sizeof(double) && std::is_trivially_copyable_v<Point>,
+              "Point must have the layout of two consecutive doubles");
+
+/**
+ * @brief Builds points from interleaved coordinates.
+ * @details Point has the layout of two doubles, so the coordinates are copied in bulk.
+ * @param coords Coordinates x0, y0, x1, y1, ... of the points.
+ * @param point_num The number of points.
+ * @return The points.
+ */
+inline std::vector<Point> PointsFromCoordinates(const double *coords, size_t point_num)
+{
+  std::vector<Point> points(point_num);
+  if (point_num > 0)
+  {
+    std::memcpy(points.data(), coords, point_num * sizeof(Point));
+  }
+  return points;
+}
@@ -0,0 +1,243 @@
+#include "api/BatchRunner.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#include "api/SimulationManager.hpp"
+#include "core/ThreadPool.hpp"
+
+namespace
+{
+  /**
+   * @brief Finds the nearest-rank percentile of a histogram.
+   * @param histogram Counts of values 0, 1, 2, ...
+   * @param total The sum of the counts, positive.
+   * @param p The percentile, between 0 and 1.
+   * @return The smallest value whose cumulative count reaches p * total.
+   */
+  template <typename Histogram>
+  size_t HistogramPercentile(const Histogram &histogram, uint64_t total, float p)
+  {
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(static_cast<double>(p) * total)));
+    uint64_t cumulative = 0;
+    for (size_t value = 0; value < histogram.size(); ++value)
+    {
+      cumulative += histogram[value];
+      if (cumulative >= rank)
+      {
+        return value;
+      }
+    }
+    return histogram.size() - 1;
+  }
+
+  /**
+   * @class BatchAccumulator
+   * @brief Merges finished runs into histograms indexed by tick.
+   * @details Everything is integer counts, so the result does not depend on the order of merges.
+   */
+  class BatchAccumulator
+  {
+    static constexpr uint32_t kBinNum = BatchStatistics::kCoverageBins + 1; ///< Bins of coverage 0, 1 / kCoverageBins, ..., 1.
+
+    uint32_t target_num_;                 ///< The number of targets of every run.
+    uint32_t run_num_ = 0;                ///< The number of merged runs.
+    std::vector<uint32_t> lifetimes_;     ///< Number of runs by lifetime.
+    std::vector<uint64_t> covered_sum_;   ///< Sum of covered targets over runs, by tick.
+    std::vector<uint32_t> coverage_bins_; ///< Number of runs by tick and coverage bin, kBinNum entries per tick.
+
+  public:
+    explicit BatchAccumulator(uint32_t target_num) : target_num_(target_num) {}
+    /**
+     * @brief Adds a successful run.
+     * @param covered The number of covered targets at ticks 0, 1, ..., lifetime.
+     */
+    void Add(const std::vector<uint32_t> &covered)
+    {
+      uint32_t lifetime = covered.size() - 1;
+      if (lifetimes_.size() <= lifetime)
+      {
+        lifetimes_.resize(lifetime + 1, 0);
+        covered_sum_.resize(lifetime + 1, 0);
+        coverage_bins_.resize(size_t{lifetime + 1} * kBinNum, 0);
+      }
+      ++lifetimes_[lifetime];
+      for (size_t tick = 0; tick < covered.size(); ++tick)
+      {
+        covered_sum_[tick] += covered[tick];
+        uint64_t bin = (uint64_t{covered[tick]} * BatchStatistics::kCoverageBins * 2 + target_num_) / (uint64_t{target_num_} * 2);
+        ++coverage_bins_[tick * kBinNum + bin];
+      }
+      ++run_num_;
+    }
+    /**
+     * @brief Computes the statistics of the merged runs.
+     * @param percentiles The percentiles to report.
+     * @param failed_run_num The number of failed runs, passed through.
+     * @return The statistics.
+     */
+    BatchStatistics Finish(const std::vector<float> &percentiles, uint32_t failed_run_num) const
+    {
+      BatchStatistics statistics;
+      statistics.run_num = run_num_;
+      statistics.failed_run_num = failed_run_num;
+      if (run_num_ == 0)
+      {
+        return statistics;
+      }
+      double sum = 0.0, square_sum = 0.0;
+      for (size_t lifetime = 0; lifetime < lifetimes_.size(); ++lifetime)
+      {
+        sum += static_cast<double>(lifetime) * lifetimes_[lifetime];
+        square_sum += static_cast<double>(lifetime) * lifetime * lifetimes_[lifetime];
+      }
+      statistics.lifetime_mean = sum / run_num_;
+      statistics.lifetime_stddev = std::sqrt(std::max(0.0, square_sum / run_num_ - statistics.lifetime_mean * statistics.lifetime_mean));
+      statistics.lifetime_min = std::find_if(lifetimes_.begin(), lifetimes_.end(), [](uint32_t n)
+                                             { return n > 0; }) -
+                                lifetimes_.begin();
+      statistics.lifetime_max = lifetimes_.size() - 1;
+
+      size_t tick_num = lifetimes_.size();
+      statistics.coverage_mean.resize(tick_num);
+      statistics.coverage_percentiles.assign(percentiles.size(), std::vector<float>(tick_num));
+      std::vector<uint32_t> bins(kBinNum);
+      for (size_t tick = 0; tick < tick_num; ++tick)
+      {
+        statistics.coverage_mean[tick] = static_cast<float>(static_cast<double>(covered_sum_[tick]) / (static_cast<double>(run_num_) * target_num_));
+        // runs that stopped before this tick count as uncovered
+        std::copy_n(coverage_bins_.begin() + tick * kBinNum, kBinNum, bins.begin());
+        uint32_t alive = 0;
+        for (uint32_t n : bins)
+        {
+          alive += n;
+        }
+        bins[0] += run_num_ - alive;
+        for (size_t k = 0; k < percentiles.size(); ++k)
+        {
+          statistics.coverage_percentiles[k][tick] = static_cast<float>(HistogramPercentile(bins, run_num_, percentiles[k])) / BatchStatistics::kCoverageBins;
+        }
+      }
+      for (float p : percentiles)
+      {
+        statistics.lifetime_percentiles.emplace_back(HistogramPercentile(lifetimes_, run_num_, p));
+      }
+      return statistics;
+    }
+  };
+}
+
+BatchRunner::BatchRunner(BatchSpec spec) : spec_(std::move(spec))
+{
+  SimulationManager::ValidateParameters(spec_.parameters);
+  if (spec_.target_num == 0 || spec_.sensor_num == 0)
+  {
+    throw std::runtime_error("Batch scenarios must contain at least one target and one sensor");
+  }
+  if (spec_.run_num == 0)
+  {
+    throw std::runtime_error("Batch must contain at least one run");
+  }
+  for (float p : spec_.percentiles)
+  {
+    if (!(p >= 0.0f && p <= 1.0f))
+    {
+      throw std::runtime_error("Percentiles must be between 0 and 1");
+    }
+  }
+}
+
+BatchStatistics BatchRunner::Run(const std::function<void(const BatchRunSummary &)> &on_run, TaskControl *control) const
+{
+  BatchAccumulator accumulator(spec_.target_num);
+  uint32_t failed_run_num = 0;
+  uint32_t finished_run_num = 0;
+  std::mutex mutex; // guards the accumulator, the counters and calls of on_run
+  std::atomic<bool> aborted = false;
+
+  auto run_one = [&](uint32_t run)
+  {
+    if (aborted.load(std::memory_order_relaxed) || (control && control->IsCancelled()))
+    {
+      return;
+    }
+    BatchRunSummary summary;
+    summary.run = run;
+    summary.seed = spec_.generator.seed + run;
+    std::vector<uint32_t> covered;
+    try
+    {
+      Simulation simulation;
+      {
+        ScenarioGeneratorOptions options = spec_.generator;
+        options.seed = summary.seed;
+        SimulationScenario scenario = GenerateScenario(spec_.target_num, spec_.sensor_num, options);
+        simulation.Initialize(spec_.parameters, scenario, spec_.ordering);
+      }
+      RunSummary run_summary = SimulationManager::RunToEnd(simulation, spec_.parameters, 0, control, [&](uint32_t covered_target_count)
+                                                           { covered.emplace_back(covered_target_count); });
+      if (!run_summary.finished)
+      {
+        return;
+      }
+      summary.lifetime = run_summary.lifetime;
+      summary.initial_coverage = run_summary.initial_coverage;
+      summary.final_coverage = run_summary.final_coverage;
+    }
+    catch (const std::exception &e)
+    {
+      summary.failed = true;
+      summary.error = e.what();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (summary.failed)
+    {
+      ++failed_run_num;
+    }
+    else
+    {
+      accumulator.Add(covered);
+    }
+    ++finished_run_num;
+    if (control)
+    {
+      control->SetProgress(static_cast<float>(finished_run_num) / spec_.run_num);
+    }
+    if (on_run)
+    {
+      try
+      {
+        on_run(summary);
+      }
+      catch (...)
+      {
+        aborted = true;
+        throw;
+      }
+    }
+  };
+
+  // ranges are split in halves: a worker keeps the lower half and leaves the upper one for thieves,
+  // so idle workers take large ranges and the queues hold O(log run_num) jobs each
+  ThreadPool pool(spec_.thread_num);
+  std::function<void(uint32_t, uint32_t)> run_range = [&](uint32_t begin, uint32_t end)
+  {
+    while (end - begin > 1)
+    {
+      uint32_t mid = begin + (end - begin) / 2;
+      pool.Submit([&run_range, mid, end]()
+                  { run_range(mid, end); });
+      end = mid;
+    }
+    run_one(begin);
+  };
+  pool.Submit([&]()
+              { run_range(0, spec_.run_num); });
+  pool.Wait();
+  if (control)
+  {
+    control->ThrowIfCancelled();
+  }
+  return accumulator.Finish(spec_.percentiles, failed_run_num);
+}
@@ -0,0 +1,228 @@
+#include "api/BinaryHistory.hpp"
+
+#include <bit>
+#include <algorithm>
+
+static_assert(std::endian::native == std::endian::little, "The binary history format is little-endian");
+
+/**
+ * @brief Rounds a size up to a multiple of 8 bytes, so every column is aligned for any of its element types.
+ */
+static size_t Align8(size_t size)
+{
+  return (size + 7) & ~size_t{7};
+}
+
+BinaryHistoryLayout::BinaryHistoryLayout(const BinaryHistoryHeader &header)
+    : block_ticks(header.block_ticks),
+      sensor_num(header.sensor_num),
+      coverage_words((header.target_num + 63) / 64)
+{
+  tick_offset = 0;
+  covered_offset = tick_offset + Align8(block_ticks * sizeof(uint32_t));
+  percentage_offset = covered_offset + Align8(block_ticks * sizeof(uint32_t));
+  state_offset = percentage_offset + Align8(block_ticks * sizeof(float));
+  battery_offset = state_offset + Align8(block_ticks * sensor_num * sizeof(uint8_t));
+  coverage_offset = battery_offset + Align8(block_ticks * sensor_num * sizeof(int32_t));
+  block_size = coverage_offset + block_ticks * coverage_words * sizeof(uint64_t);
+}
+
+BinaryStateSink::BinaryStateSink(const std::string &path, uint32_t block_ticks)
+    : file_(path, std::ios::binary | std::ios::trunc), header_{}
+{
+  if (!file_.is_open())
+  {
+    throw std::runtime_error("Failed to open file for writing: " + path);
+  }
+  std::memcpy(header_.magic, BinaryHistoryHeader::kMagic, sizeof(header_.magic));
+  header_.version = BinaryHistoryHeader::kVersion;
+  header_.block_ticks = block_ticks;
+}
+
+BinaryStateSink::~BinaryStateSink()
+{
+  try
+  {
+    Flush();
+  }
+  catch (...)
+  {
+    // destructors must not throw, call Flush explicitly to observe errors
+  }
+}
+
+void BinaryStateSink::Append(const SimulationState &state)
+{
+  size_t sensor_num = state.sensor_states.size();
+  size_t target_num = state.is_target_covered.size();
+  if (header_.tick_count == 0)
+  {
+    header_.sensor_num = sensor_num;
+    header_.target_num = target_num;
+    if (header_.block_ticks == 0)
+    {
+      constexpr size_t kBlockBytes = size_t{4} << 20;
+      size_t row_size = 3 * sizeof(uint32_t) + sensor_num * (sizeof(uint8_t) + sizeof(int32_t)) + (target_num + 63) / 64 * sizeof(uint64_t);
+      header_.block_ticks = static_cast<uint32_t>(std::clamp<size_t>(kBlockBytes / row_size, 1, 256));
+    }
+    layout_ = BinaryHistoryLayout(header_);
+    block_.assign(layout_.block_size, 0);
+  }
+  if (sensor_num != header_.sensor_num || state.sensor_battery_lvls.size() != sensor_num || target_num != header_.target_num)
+  {
+    throw std::runtime_error("State does not match the dimensions of the binary history");
+  }
+  size_t row = block_fill_;
+  uint8_t *block = block_.data();
+  std::memcpy(block + layout_.tick_offset + row * sizeof(uint32_t), &state.tick, sizeof(uint32_t));
+  std::memcpy(block + layout_.covered_offset + row * sizeof(uint32_t), &state.covered_target_count, sizeof(uint32_t));
+  std::memcpy(block + layout_.percentage_offset + row * sizeof(float), &state.coverage_percentage, sizeof(float));
+  uint8_t *states = block + layout_.state_offset + row * sensor_num;
+  for (size_t i = 0; i < sensor_num; ++i)
+  {
+    states[i] = static_cast<uint8_t>(state.sensor_states[i]);
+  }
+  std::memcpy(block + layout_.battery_offset + row * sensor_num * sizeof(int32_t), state.sensor_battery_lvls.data(), sensor_num * sizeof(int32_t));
+  uint8_t *coverage = block + layout_.coverage_offset + row * layout_.coverage_words * sizeof(uint64_t);
+  for (size_t w = 0; w < layout_.coverage_words; ++w)
+  {
+    uint64_t word = 0;
+    for (size_t t = w * 64; t < std::min(target_num, w * 64 + 64); ++t)
+    {
+      word |= uint64_t{state.is_target_covered[t]} << (t % 64);
+    }
+    std::memcpy(coverage + w * sizeof(uint64_t), &word, sizeof(uint64_t));
+  }
+  ++header_.tick_count;
+  if (++block_fill_ == layout_.block_ticks)
+  {
+    WriteBlock();
+    ++block_index_;
+    block_fill_ = 0;
+    std::fill(block_.begin(), block_.end(), uint8_t{0});
+  }
+}
+
+void BinaryStateSink::Flush()
+{
+  if (block_fill_ > 0)
+  {
+    WriteBlock(); // rewritten once the block is full
+  }
+  file_.seekp(0);
+  file_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+  file_.flush();
+  if (!file_)
+  {
+    throw std::runtime_error("Failed to write binary history");
+  }
+}
+
+void BinaryStateSink::WriteBlock()
+{
+  file_.seekp(layout_.BlockOffset(block_index_));
+  file_.write(reinterpret_cast<const char *>(block_.data()), block_.size());
+}
+
+BinaryHistoryReader::BinaryHistoryReader(const std::string &path) : file_(path)
+{
+  if (file_.Size() < sizeof(BinaryHistoryHeader))
+  {
+    throw std::runtime_error("File is too small to be a binary history: " + path);
+  }
+  std::memcpy(&header_, file_.Data(), sizeof(header_));
+  if (std::memcmp(header_.magic, BinaryHistoryHeader::kMagic, sizeof(header_.magic)) != 0)
+  {
+    throw std::runtime_error("File is not a binary history: " + path);
+  }
+  if (header_.version != BinaryHistoryHeader::kVersion)
+  {
+    throw std::runtime_error("Unsupported binary history version " + std::to_string(header_.version) + ": " + path);
+  }
+  if (header_.tick_count > 0)
+  {
+    if (header_.block_ticks == 0)
+    {
+      throw std::runtime_error("Binary history has empty blocks: " + path);
+    }
+    layout_ = BinaryHistoryLayout(header_);
+    size_t block_num = (header_.tick_count + header_.block_ticks - 1) / header_.block_ticks;
+    if (file_.Size() < layout_.BlockOffset(block_num))
+    {
+      throw std::runtime_error("Binary history is truncated: " + path);
+    }
+  }
+}
+
+void BinaryHistoryReader::CheckIndex(size_t index) const
+{
+  // an empty file has no layout, so this also guards the division by block_ticks
+  if (index >= header_.tick_count)
+  {
+    throw std::out_of_range("State index " + std::to_string(index) + " out of range");
+  }
+}
+
+uint32_t BinaryHistoryReader::GetTick(size_t index) const
+{
+  CheckIndex(index);
+  return ReadValue<uint32_t>(layout_.tick_offset, index);
+}
+
+SimulationState BinaryHistoryReader::GetState(size_t index) const
+{
+  CheckIndex(index);
+  size_t sensor_num = header_.sensor_num;
+  size_t target_num = header_.target_num;
+  size_t row = index % layout_.block_ticks;
+  const uint8_t *block = file_.Data() + layout_.BlockOffset(index / layout_.block_ticks);
+
+  SimulationState state;
+  state.tick = GetTick(index);
+  state.covered_target_count = ReadValue<uint32_t>(layout_.covered_offset, index);
+  state.coverage_percentage = ReadValue<float>(layout_.percentage_offset, index);
+  state.all_target_covered = state.covered_target_count == target_num;
+  const uint8_t *states = block + layout_.state_offset + row * sensor_num;
+  state.sensor_states.resize(sensor_num);
+  for (size_t i = 0; i < sensor_num; ++i)
+  {
+    state.sensor_states[i] = static_cast<Sensor::State>(states[i]);
+  }
+  state.sensor_battery_lvls.resize(sensor_num);
+  std::memcpy(state.sensor_battery_lvls.data(), block + layout_.battery_offset + row * sensor_num * sizeof(int32_t), sensor_num * sizeof(int32_t));
+  const uint8_t *words = block + layout_.coverage_offset + row * layout_.coverage_words * sizeof(uint64_t);
+  state.is_target_covered.resize(target_num);
+  for (size_t w = 0; w < layout_.coverage_words; ++w)
+  {
+    uint64_t word;
+    std::memcpy(&word, words + w * sizeof(uint64_t), sizeof(uint64_t));
+    for (size_t t = w * 64; t < std::min(target_num, w * 64 + 64); ++t)
+    {
+      state.is_target_covered[t] = (word >> (t % 64)) & 1;
+    }
+  }
+  return state;
+}
+
+SimulationState BinaryHistoryReader::GetStateAt(uint32_t tick) const
+{
+  // ticks are stored in increasing order, usually consecutive
+  size_t lo = 0, hi = header_.tick_count;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (GetTick(mid) < tick)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  if (lo == header_.tick_count || GetTick(lo) != tick)
+  {
+    throw std::runtime_error("No state stored at tick " + std::to_string(tick));
+  }
+  return GetState(lo);
+}
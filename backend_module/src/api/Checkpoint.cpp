@@ -0,0 +1,415 @@
+#include "api/Checkpoint.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+
+static_assert(std::endian::native == std::endian::little, "The checkpoint format is little-endian");
+
+namespace
+{
+  constexpr uint64_t kFnvOffset = 14695981039346656037ull; ///< Initial value of the FNV-1a hash.
+  constexpr uint64_t kFnvPrime = 1099511628211ull;         ///< Multiplier of the FNV-1a hash.
+  constexpr uint8_t kPadding[8] = {};                      ///< Zero bytes padding arrays to a multiple of 8 bytes.
+
+  /**
+   * @brief Continues an FNV-1a hash over raw bytes.
+   * @param hash The hash so far.
+   * @param data The bytes.
+   * @param size The number of bytes.
+   * @return The updated hash.
+   */
+  uint64_t HashBytes(uint64_t hash, const void *data, size_t size)
+  {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+      hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+    return hash;
+  }
+
+  /**
+   * @class ArrayWriter
+   * @brief Writes arrays to a stream, hashing everything it writes.
+   * @details Without a stream only the hash is computed.
+   */
+  class ArrayWriter
+  {
+    std::ostream *out_;          ///< The output, or null to only hash.
+    uint64_t hash_ = kFnvOffset; ///< FNV-1a hash of the bytes written so far.
+
+  public:
+    explicit ArrayWriter(std::ostream *out) : out_(out) {}
+    uint64_t Hash() const { return hash_; } ///< Gets the hash of the bytes written so far.
+    /**
+     * @brief Writes raw bytes.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     */
+    void Append(const void *data, size_t size)
+    {
+      hash_ = HashBytes(hash_, data, size);
+      if (out_)
+      {
+        out_->write(reinterpret_cast<const char *>(data), size);
+      }
+    }
+    /**
+     * @brief Writes an array: its element count, its elements and the padding.
+     * @param values The elements; their type must have no padding bytes, so the hash is deterministic.
+     * Structures with padding, such as Edge, are written with WriteColumn.
+     */
+    template <typename T>
+    void WriteArray(std::span<const T> values)
+    {
+      static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, Point> || std::is_same_v<T, Cover>, "Arrays hold numbers, points or covers");
+      static_assert(std::has_unique_object_representations_v<T> || std::is_floating_point_v<T> || std::is_same_v<T, Point>, "Arrays hold no padding");
+      uint64_t count = values.size();
+      Append(&count, sizeof(count));
+      Append(values.data(), values.size_bytes());
+      Append(kPadding, (8 - values.size_bytes() % 8) % 8);
+    }
+    /**
+     * @brief Writes one field of every element as an array.
+     * @param values The elements.
+     * @param field Function returning the field of an element.
+     */
+    template <typename T, typename Field>
+    void WriteColumn(std::span<const T> values, Field field)
+    {
+      using Value = std::invoke_result_t<Field, const T &>;
+      std::vector<Value> column;
+      column.reserve(values.size());
+      for (const T &value : values)
+      {
+        column.emplace_back(field(value));
+      }
+      WriteArray<Value>(column);
+    }
+  };
+
+  /**
+   * @class ArrayReader
+   * @brief Reads arrays from the body of a mapped file, hashing everything it reads.
+   */
+  class ArrayReader
+  {
+    const uint8_t *data_;        ///< Start of the body.
+    size_t size_;                ///< Size of the body in bytes.
+    size_t pos_ = 0;             ///< Offset of the next array.
+    uint64_t hash_ = kFnvOffset; ///< FNV-1a hash of the bytes read so far.
+    const std::string &path_;    ///< The path of the file, used in error messages.
+
+    /**
+     * @brief Consumes raw bytes.
+     * @param size The number of bytes.
+     * @return The start of the bytes.
+     * @exception Throws std::runtime_error if the body ends earlier.
+     */
+    const uint8_t *Consume(size_t size)
+    {
+      if (size > size_ - pos_)
+      {
+        throw std::runtime_error("File is truncated: " + path_);
+      }
+      const uint8_t *bytes = data_ + pos_;
+      hash_ = HashBytes(hash_, bytes, size);
+      pos_ += size;
+      return bytes;
+    }
+
+  public:
+    ArrayReader(const uint8_t *data, size_t size, const std::string &path) : data_(data), size_(size), path_(path) {}
+    uint64_t Hash() const { return hash_; }      ///< Gets the hash of the bytes read so far.
+    bool AtEnd() const { return pos_ == size_; } ///< Checks if the whole body has been read.
+    /**
+     * @brief Reads an array written by ArrayWriter::WriteArray.
+     * @return The elements.
+     * @exception Throws std::runtime_error if the body ends earlier.
+     */
+    template <typename T>
+    std::vector<T> ReadArray()
+    {
+      uint64_t count;
+      std::memcpy(&count, Consume(sizeof(count)), sizeof(count));
+      if (count > (size_ - pos_) / sizeof(T))
+      {
+        throw std::runtime_error("File is truncated: " + path_);
+      }
+      std::vector<T> values(count);
+      std::memcpy(values.data(), Consume(count * sizeof(T)), count * sizeof(T));
+      Consume((8 - count * sizeof(T) % 8) % 8);
+      return values;
+    }
+    /**
+     * @brief Reads an array of a given length.
+     * @param count The expected number of elements.
+     * @return The elements.
+     * @exception Throws std::runtime_error if the body ends earlier or the array has another length.
+     */
+    template <typename T>
+    std::vector<T> ReadArray(size_t count)
+    {
+      std::vector<T> values = ReadArray<T>();
+      if (values.size() != count)
+      {
+        throw std::runtime_error("File is corrupted: " + path_);
+      }
+      return values;
+    }
+  };
+
+  /**
+   * @brief Fills the header of a layout file, all but its content hash.
+   * @param scenario The scenario the layout was computed for.
+   * @param layout The layout.
+   * @return The header.
+   */
+  LayoutFileHeader MakeLayoutHeader(ScenarioView scenario, const SimulationLayout &layout)
+  {
+    LayoutFileHeader header{};
+    std::memcpy(header.magic, LayoutFileHeader::kMagic, sizeof(header.magic));
+    header.version = LayoutFileHeader::kVersion;
+    header.sensor_radius = layout.sensor_radius;
+    header.target_num = scenario.target_positions.size();
+    header.sensor_num = scenario.sensor_positions.size();
+    header.cover_num = layout.storage->GetCoverNum();
+    return header;
+  }
+
+  /**
+   * @brief Completes the content hash of a layout file with the header fields its reader relies on.
+   * @details Layout files are named after this hash, so scenarios whose covers are equal for two radii
+   * still get a file per radius.
+   * @param body_hash The hash of the body.
+   * @param header The header.
+   * @return The content hash.
+   */
+  uint64_t LayoutContentHash(uint64_t body_hash, const LayoutFileHeader &header)
+  {
+    uint64_t hash = HashBytes(body_hash, &header.sensor_radius, sizeof(header.sensor_radius));
+    hash = HashBytes(hash, &header.target_num, sizeof(header.target_num));
+    hash = HashBytes(hash, &header.sensor_num, sizeof(header.sensor_num));
+    return HashBytes(hash, &header.cover_num, sizeof(header.cover_num));
+  }
+
+  void WriteLayoutBody(ArrayWriter &writer, ScenarioView scenario, const SimulationLayout &layout)
+  {
+    const CoverStorage &storage = *layout.storage;
+    writer.WriteArray(scenario.target_positions);
+    writer.WriteArray(scenario.sensor_positions);
+    writer.WriteColumn<size_t>(layout.target_input_idx, [](size_t idx) { return static_cast<uint64_t>(idx); });
+    writer.WriteColumn<size_t>(layout.sensor_input_idx, [](size_t idx) { return static_cast<uint64_t>(idx); });
+    writer.WriteArray<uint32_t>(storage.GetSensorTargets().offsets);
+    writer.WriteArray<uint32_t>(storage.GetSensorTargets().indices);
+    writer.WriteArray<uint32_t>(storage.GetSensorSensors().offsets);
+    writer.WriteArray<uint32_t>(storage.GetSensorSensors().indices);
+    writer.WriteArray<uint32_t>(storage.GetCoverOffsets());
+    writer.WriteArray<Cover>(storage.GetInitialCovers());
+    writer.WriteArray<uint32_t>(storage.GetEdgeOffsets());
+    writer.WriteColumn<Edge>(storage.GetEdges(), [](const Edge &e) { return e.first; });
+    writer.WriteColumn<Edge>(storage.GetEdges(), [](const Edge &e) { return e.second; });
+  }
+
+  void WriteSnapshotBody(ArrayWriter &writer, const SimulationSnapshot &snapshot)
+  {
+    writer.WriteArray<uint16_t>(snapshot.battery_lvls);
+    writer.WriteColumn<Sensor::State>(snapshot.states, [](Sensor::State state) { return static_cast<uint8_t>(state); });
+    writer.WriteArray<uint32_t>(snapshot.cover_indices);
+    writer.WriteArray<uint8_t>(snapshot.target_flags);
+    writer.WriteArray<Cover>(snapshot.covers);
+  }
+
+  /**
+   * @brief Writes a file under a temporary name and renames it to its path when complete.
+   * @param path The path to the output file.
+   * @param header The header, written before the body and again once the body is hashed.
+   * @param write_body Function writing the body and returning its hash.
+   * @param set_hash Function storing the hash in the header.
+   */
+  template <typename Header, typename WriteBody, typename SetHash>
+  void WriteAtomically(const std::string &path, Header header, WriteBody write_body, SetHash set_hash)
+  {
+    std::string temp_path = path + ".tmp";
+    {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      if (!file.is_open())
+      {
+        throw std::runtime_error("Failed to open file for writing: " + temp_path);
+      }
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      ArrayWriter writer(&file);
+      write_body(writer);
+      set_hash(header, writer.Hash());
+      file.seekp(0);
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.flush();
+      if (!file)
+      {
+        throw std::runtime_error("Failed to write file: " + temp_path);
+      }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+      throw std::runtime_error("Failed to replace file " + path + ": " + error.message());
+    }
+  }
+}
+
+uint64_t HashLayout(ScenarioView scenario, const SimulationLayout &layout)
+{
+  ArrayWriter writer(nullptr);
+  WriteLayoutBody(writer, scenario, layout);
+  return LayoutContentHash(writer.Hash(), MakeLayoutHeader(scenario, layout));
+}
+
+std::string LayoutFilePath(const std::string &checkpoint_path, uint64_t layout_hash)
+{
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << layout_hash << ".wsnlayout";
+  return (std::filesystem::path(checkpoint_path).parent_path() / name.str()).string();
+}
+
+void WriteLayoutFile(const std::string &path, ScenarioView scenario, const SimulationLayout &layout)
+{
+  WriteAtomically(
+      path, MakeLayoutHeader(scenario, layout), [&](ArrayWriter &writer)
+      { WriteLayoutBody(writer, scenario, layout); },
+      [](LayoutFileHeader &header, uint64_t hash)
+      { header.content_hash = LayoutContentHash(hash, header); });
+}
+
+void ReadLayoutFile(const std::string &path, uint64_t layout_hash, SimulationScenario &scenario, SimulationLayout &layout)
+{
+  MappedFile file(path);
+  LayoutFileHeader header;
+  if (file.Size() < sizeof(header))
+  {
+    throw std::runtime_error("File is too small to be a layout file: " + path);
+  }
+  std::memcpy(&header, file.Data(), sizeof(header));
+  if (std::memcmp(header.magic, LayoutFileHeader::kMagic, sizeof(header.magic)) != 0)
+  {
+    throw std::runtime_error("File is not a layout file: " + path);
+  }
+  if (header.version != LayoutFileHeader::kVersion)
+  {
+    throw std::runtime_error("Unsupported layout file version " + std::to_string(header.version) + ": " + path);
+  }
+  if (header.content_hash != layout_hash)
+  {
+    throw std::runtime_error("Layout file does not belong to the checkpoint: " + path);
+  }
+  ArrayReader reader(file.Data() + sizeof(header), file.Size() - sizeof(header), path);
+  scenario.target_positions = reader.ReadArray<Point>(header.target_num);
+  scenario.sensor_positions = reader.ReadArray<Point>(header.sensor_num);
+  auto target_input_idx = reader.ReadArray<uint64_t>(header.target_num);
+  auto sensor_input_idx = reader.ReadArray<uint64_t>(header.sensor_num);
+  CsrGraph sensor_targets{reader.ReadArray<uint32_t>(header.sensor_num + 1), reader.ReadArray<uint32_t>()};
+  CsrGraph sensor_sensors{reader.ReadArray<uint32_t>(header.sensor_num + 1), reader.ReadArray<uint32_t>()};
+  auto cover_offsets = reader.ReadArray<uint32_t>(header.sensor_num + 1);
+  auto initial_covers = reader.ReadArray<Cover>(header.cover_num);
+  auto edge_offsets = reader.ReadArray<uint32_t>(header.cover_num + 1);
+  auto edge_covers = reader.ReadArray<uint32_t>();
+  auto edge_weights = reader.ReadArray<uint16_t>(edge_covers.size());
+  if (!reader.AtEnd() || LayoutContentHash(reader.Hash(), header) != header.content_hash)
+  {
+    throw std::runtime_error("Layout file is corrupted: " + path);
+  }
+  std::vector<Edge> edges(edge_covers.size());
+  for (size_t e = 0; e < edges.size(); ++e)
+  {
+    edges[e] = Edge(edge_covers[e], edge_weights[e]);
+  }
+  layout.sensor_radius = header.sensor_radius;
+  layout.target_input_idx.assign(target_input_idx.begin(), target_input_idx.end());
+  layout.sensor_input_idx.assign(sensor_input_idx.begin(), sensor_input_idx.end());
+  layout.storage = std::make_shared<const CoverStorage>(std::move(sensor_targets), std::move(sensor_sensors), std::move(cover_offsets), std::move(initial_covers),
+                                                        std::move(edge_offsets), std::move(edges));
+}
+
+void WriteCheckpoint(const std::string &path, const Checkpoint &checkpoint)
+{
+  CheckpointHeader header{};
+  std::memcpy(header.magic, CheckpointHeader::kMagic, sizeof(header.magic));
+  header.version = CheckpointHeader::kVersion;
+  header.spatial_ordering = static_cast<uint32_t>(checkpoint.ordering);
+  header.layout_hash = checkpoint.layout_hash;
+  header.sensor_radius = checkpoint.parameters.sensor_radius;
+  header.initial_battery_lvl = checkpoint.parameters.initial_battery_lvl;
+  header.reshuffle_interval = checkpoint.parameters.reshuffle_interval;
+  header.max_ticks = checkpoint.parameters.max_ticks;
+  header.stop_condition = static_cast<uint32_t>(checkpoint.parameters.stop_condition);
+  header.stop_threshold = checkpoint.parameters.stop_threshold;
+  header.ticks_run = checkpoint.ticks_run;
+  header.tick = checkpoint.snapshot.tick;
+  header.finished = checkpoint.finished;
+  WriteAtomically(
+      path, header, [&](ArrayWriter &writer)
+      { WriteSnapshotBody(writer, checkpoint.snapshot); },
+      [](CheckpointHeader &header, uint64_t hash)
+      { header.content_hash = hash; });
+}
+
+Checkpoint ReadCheckpoint(const std::string &path)
+{
+  MappedFile file(path);
+  CheckpointHeader header;
+  if (file.Size() < sizeof(header))
+  {
+    throw std::runtime_error("File is too small to be a checkpoint: " + path);
+  }
+  std::memcpy(&header, file.Data(), sizeof(header));
+  if (std::memcmp(header.magic, CheckpointHeader::kMagic, sizeof(header.magic)) != 0)
+  {
+    throw std::runtime_error("File is not a checkpoint: " + path);
+  }
+  if (header.version != CheckpointHeader::kVersion)
+  {
+    throw std::runtime_error("Unsupported checkpoint version " + std::to_string(header.version) + ": " + path);
+  }
+  if (header.spatial_ordering > static_cast<uint32_t>(SpatialOrdering::kHilbert) ||
+      header.stop_condition > static_cast<uint32_t>(SimulationStopCondition::kAnyCoverageLost))
+  {
+    throw std::runtime_error("Checkpoint file is corrupted: " + path);
+  }
+  Checkpoint checkpoint;
+  checkpoint.layout_hash = header.layout_hash;
+  checkpoint.parameters = SimulationParameters(header.sensor_radius, header.initial_battery_lvl, header.reshuffle_interval,
+                                               static_cast<SimulationStopCondition>(header.stop_condition), header.stop_threshold, header.max_ticks);
+  checkpoint.ordering = static_cast<SpatialOrdering>(header.spatial_ordering);
+  checkpoint.ticks_run = header.ticks_run;
+  checkpoint.finished = header.finished != 0;
+
+  SimulationSnapshot &snapshot = checkpoint.snapshot;
+  snapshot.initial_battery_lvl = header.initial_battery_lvl;
+  snapshot.reshuffle_interval = header.reshuffle_interval;
+  snapshot.tick = header.tick;
+  ArrayReader reader(file.Data() + sizeof(header), file.Size() - sizeof(header), path);
+  snapshot.battery_lvls = reader.ReadArray<uint16_t>();
+  size_t sensor_num = snapshot.battery_lvls.size();
+  auto states = reader.ReadArray<uint8_t>(sensor_num);
+  snapshot.cover_indices = reader.ReadArray<uint32_t>(sensor_num);
+  snapshot.target_flags = reader.ReadArray<uint8_t>();
+  snapshot.covers = reader.ReadArray<Cover>();
+  if (!reader.AtEnd() || reader.Hash() != header.content_hash)
+  {
+    throw std::runtime_error("Checkpoint file is corrupted: " + path);
+  }
+  snapshot.states.reserve(sensor_num);
+  for (uint8_t state : states)
+  {
+    if (state > static_cast<uint8_t>(Sensor::State::kUndecided))
+    {
+      throw std::runtime_error("Checkpoint file is corrupted: " + path);
+    }
+    snapshot.states.emplace_back(static_cast<Sensor::State>(state));
+  }
+  return checkpoint;
+}
@@ -0,0 +1,493 @@
+#include "api/ConfigReader.hpp"
+
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <string_view>
+
+#include "core/parallel.hpp"
+#include "api/MappedFile.hpp"
+#include "api/json.hpp"
+
+using json = nlohmann::json;
+
+namespace
+{
+  /**
+   * @brief Kinds of JSON containers the handler can be inside of.
+   */
+  enum class Container
+  {
+    kRoot,       ///< The root object of the config.
+    kParameters, ///< The "parameters" object or a value nested in it, collected as JSON.
+    kScenario,   ///< The "scenario" object.
+    kPointArray, ///< An array of positions of the scenario.
+    kPoint,      ///< A single position.
+    kIgnored,    ///< A value of an unknown key, skipped.
+  };
+
+  /**
+   * @class ConfigHandler
+   * @brief SAX handler of nlohmann::json that extracts a config while the file is parsed.
+   */
+  class ConfigHandler
+  {
+    const std::string &path_;              ///< The path of the parsed file, for error messages.
+    bool read_parameters_;                 ///< Whether the "parameters" object is collected.
+    bool read_scenario_;                   ///< Whether the "scenario" object is collected.
+    std::vector<Container> stack_;         ///< Containers enclosing the current value, innermost last.
+    std::string key_;                      ///< The key of the current value, if inside an object.
+    std::vector<json *> parameter_stack_;  ///< Collected containers of the "parameters" object, innermost last.
+    std::vector<Point> *points_ = nullptr; ///< The positions being filled, if inside a point array.
+    bool has_x_ = false;                   ///< Whether the current point has an x coordinate.
+    bool has_y_ = false;                   ///< Whether the current point has a y coordinate.
+
+  public:
+    json parameters;                     ///< The collected "parameters" object.
+    bool has_parameters = false;         ///< Whether the file has a "parameters" object.
+    std::vector<Point> target_positions; ///< Positions of "scenario.target_positions".
+    std::vector<Point> sensor_positions; ///< Positions of "scenario.sensor_positions".
+    bool has_scenario = false;           ///< Whether the file has a "scenario" object.
+    bool has_target_positions = false;   ///< Whether the scenario has target positions.
+    bool has_sensor_positions = false;   ///< Whether the scenario has sensor positions.
+
+    ConfigHandler(const std::string &path, bool read_parameters, bool read_scenario)
+        : path_(path), read_parameters_(read_parameters), read_scenario_(read_scenario) {}
+
+    bool null() { return Scalar(nullptr); }
+    bool boolean(bool value) { return Scalar(value); }
+    bool number_integer(json::number_integer_t value) { return Number(value, static_cast<double>(value)); }
+    bool number_unsigned(json::number_unsigned_t value) { return Number(value, static_cast<double>(value)); }
+    bool number_float(json::number_float_t value, const json::string_t &) { return Number(value, value); }
+    bool string(json::string_t &value) { return Scalar(std::move(value)); }
+    bool binary(json::binary_t &) { return Scalar(nullptr); } // not produced by the text parser
+
+    bool start_object(size_t)
+    {
+      if (stack_.empty())
+      {
+        stack_.push_back(Container::kRoot);
+        return true;
+      }
+      switch (stack_.back())
+      {
+      case Container::kRoot:
+        if (key_ == "parameters" && read_parameters_)
+        {
+          parameters = json::object();
+          has_parameters = true;
+          parameter_stack_.push_back(&parameters);
+          stack_.push_back(Container::kParameters);
+          return true;
+        }
+        if (key_ == "scenario" && read_scenario_)
+        {
+          has_scenario = true;
+          stack_.push_back(Container::kScenario);
+          return true;
+        }
+        break;
+      case Container::kParameters:
+        parameter_stack_.push_back(&Insert(json::object()));
+        stack_.push_back(Container::kParameters);
+        return true;
+      case Container::kScenario:
+        CheckNotPositions();
+        break;
+      case Container::kPointArray:
+        points_->emplace_back();
+        has_x_ = has_y_ = false;
+        stack_.push_back(Container::kPoint);
+        return true;
+      case Container::kPoint:
+        CheckNotCoordinate();
+        break;
+      case Container::kIgnored:
+        break;
+      }
+      stack_.push_back(Container::kIgnored);
+      return true;
+    }
+
+    bool end_object()
+    {
+      if (stack_.back() == Container::kPoint && !(has_x_ && has_y_))
+      {
+        throw std::runtime_error("Position " + std::to_string(points_->size() - 1) + " does not contain 'x' and 'y' fields.");
+      }
+      return End();
+    }
+
+    bool start_array(size_t)
+    {
+      if (stack_.empty())
+      {
+        throw std::runtime_error("JSON config is not an object: " + path_);
+      }
+      switch (stack_.back())
+      {
+      case Container::kRoot:
+        CheckNotSection();
+        break;
+      case Container::kParameters:
+        parameter_stack_.push_back(&Insert(json::array()));
+        stack_.push_back(Container::kParameters);
+        return true;
+      case Container::kScenario:
+        if (key_ == "target_positions" || key_ == "sensor_positions")
+        {
+          bool targets = key_ == "target_positions";
+          points_ = targets ? &target_positions : &sensor_positions;
+          (targets ? has_target_positions : has_sensor_positions) = true;
+          points_->clear(); // a repeated key replaces the positions, as in a DOM
+          stack_.push_back(Container::kPointArray);
+          return true;
+        }
+        break;
+      case Container::kPointArray:
+        throw std::runtime_error("Positions must be objects with 'x' and 'y' fields.");
+      case Container::kPoint:
+        CheckNotCoordinate();
+        break;
+      case Container::kIgnored:
+        break;
+      }
+      stack_.push_back(Container::kIgnored);
+      return true;
+    }
+
+    bool end_array() { return End(); }
+
+    bool key(json::string_t &key)
+    {
+      key_ = std::move(key);
+      return true;
+    }
+
+    bool parse_error(size_t, const std::string &, const nlohmann::detail::exception &ex)
+    {
+      throw std::runtime_error("Failed to parse JSON file " + path_ + ": " + ex.what());
+    }
+
+  private:
+    /**
+     * @brief Handles a number, the only kind of value accepted as a coordinate.
+     * @param value The number as parsed.
+     * @param as_double The number converted to a coordinate.
+     */
+    template <typename T>
+    bool Number(T value, double as_double)
+    {
+      if (!stack_.empty() && stack_.back() == Container::kPoint)
+      {
+        if (key_ == "x")
+        {
+          points_->back().x = as_double;
+          has_x_ = true;
+        }
+        else if (key_ == "y")
+        {
+          points_->back().y = as_double;
+          has_y_ = true;
+        }
+        return true;
+      }
+      return Scalar(value);
+    }
+
+    /**
+     * @brief Handles a value other than an object or an array.
+     * @param value The value.
+     */
+    bool Scalar(json value)
+    {
+      if (stack_.empty())
+      {
+        throw std::runtime_error("JSON config is not an object: " + path_);
+      }
+      switch (stack_.back())
+      {
+      case Container::kRoot:
+        CheckNotSection();
+        break;
+      case Container::kParameters:
+        Insert(std::move(value));
+        break;
+      case Container::kScenario:
+        CheckNotPositions();
+        break;
+      case Container::kPointArray:
+        throw std::runtime_error("Positions must be objects with 'x' and 'y' fields.");
+      case Container::kPoint:
+        CheckNotCoordinate();
+        break;
+      case Container::kIgnored:
+        break;
+      }
+      return true;
+    }
+
+    /**
+     * @brief Leaves the innermost container.
+     */
+    bool End()
+    {
+      if (stack_.back() == Container::kParameters)
+      {
+        parameter_stack_.pop_back();
+      }
+      stack_.pop_back();
+      return true;
+    }
+
+    /**
+     * @brief Adds a value to the innermost collected container of the "parameters" object.
+     * @param value The value to add.
+     * @return The added value.
+     */
+    json &Insert(json value)
+    {
+      json &parent = *parameter_stack_.back();
+      if (parent.is_object())
+      {
+        return parent[key_] = std::move(value);
+      }
+      parent.push_back(std::move(value));
+      return parent.back();
+    }
+
+    void CheckNotSection() const ///< Throws if a collected section of the root object is not an object.
+    {
+      if ((key_ == "parameters" && read_parameters_) || (key_ == "scenario" && read_scenario_))
+      {
+        throw std::runtime_error("JSON field '" + key_ + "' is not an object.");
+      }
+    }
+
+    void CheckNotPositions() const ///< Throws if positions of the scenario are not an array.
+    {
+      if (key_ == "target_positions" || key_ == "sensor_positions")
+      {
+        throw std::runtime_error("Scenario field '" + key_ + "' is not an array.");
+      }
+    }
+
+    void CheckNotCoordinate() const ///< Throws if a coordinate of a position is not a number.
+    {
+      if (key_ == "x" || key_ == "y")
+      {
+        throw std::runtime_error("Position " + std::to_string(points_->size() - 1) + " has a non-numeric '" + key_ + "' field.");
+      }
+    }
+  };
+}
+
+SimulationConfig ReadConfigJSON(const std::string &json_path, bool read_parameters, bool read_scenario)
+{
+  MappedFile file(json_path);
+  ConfigHandler handler(json_path, read_parameters, read_scenario);
+  const char *begin = reinterpret_cast<const char *>(file.Data());
+  json::sax_parse(begin, begin + file.Size(), &handler);
+
+  SimulationConfig config;
+  if (handler.has_parameters)
+  {
+    try
+    {
+      config.parameters = handler.parameters.get<SimulationParameters>();
+    }
+    catch (const json::exception &e)
+    {
+      throw std::runtime_error(std::string("Invalid 'parameters' field: ") + e.what());
+    }
+  }
+  if (handler.has_scenario)
+  {
+    if (!handler.has_target_positions || !handler.has_sensor_positions)
+    {
+      throw std::runtime_error("Scenario does not contain 'target_positions' and 'sensor_positions' fields.");
+    }
+    config.scenario.emplace(std::move(handler.target_positions), std::move(handler.sensor_positions));
+  }
+  return config;
+}
+
+namespace
+{
+  /**
+   * @struct CsvChunk
+   * @brief A range of whole lines of a CSV file, parsed by one thread.
+   */
+  struct CsvChunk
+  {
+    const char *begin = nullptr; ///< Start of the first line.
+    const char *end = nullptr;   ///< End of the last line.
+    size_t line_num = 0;         ///< Number of lines, counted in the first pass.
+    size_t target_num = 0;       ///< Number of target positions, counted in the first pass.
+    size_t sensor_num = 0;       ///< Number of sensor positions, counted in the first pass.
+  };
+
+  constexpr std::string_view kTargetPrefix = "target,"; ///< Start of a line holding a target position.
+  constexpr std::string_view kSensorPrefix = "sensor,"; ///< Start of a line holding a sensor position.
+
+  /**
+   * @brief Calls f(line_begin, line_end) for every line of a range, without the line break.
+   */
+  template <typename F>
+  void ForEachLine(const char *begin, const char *end, F &&f)
+  {
+    while (begin < end)
+    {
+      const char *eol = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+      eol = eol ? eol : end;
+      f(begin, eol);
+      begin = eol == end ? end : eol + 1;
+    }
+  }
+
+  /**
+   * @brief Checks whether a line starts with a prefix.
+   */
+  bool StartsWith(const char *begin, const char *end, std::string_view prefix)
+  {
+    return static_cast<size_t>(end - begin) >= prefix.size() && std::memcmp(begin, prefix.data(), prefix.size()) == 0;
+  }
+
+  /**
+   * @brief Checks whether a line holds no position: it is empty, whitespace or a comment.
+   */
+  bool IsBlank(const char *begin, const char *end)
+  {
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+    {
+      ++begin;
+    }
+    return begin == end || *begin == '#';
+  }
+
+  /**
+   * @brief Parses the `x,y` part of a position line.
+   * @param begin The start of the coordinates, after the kind.
+   * @param end The end of the line.
+   * @param point The parsed point.
+   * @return True if the whole line was a valid pair of numbers.
+   */
+  bool ParseCoordinates(const char *begin, const char *end, Point &point)
+  {
+    auto skip_spaces = [&]()
+    {
+      while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+      {
+        ++begin;
+      }
+    };
+    skip_spaces();
+    auto [x_end, x_error] = std::from_chars(begin, end, point.x);
+    if (x_error != std::errc())
+    {
+      return false;
+    }
+    begin = x_end;
+    skip_spaces();
+    if (begin == end || *begin != ',')
+    {
+      return false;
+    }
+    ++begin;
+    skip_spaces();
+    auto [y_end, y_error] = std::from_chars(begin, end, point.y);
+    if (y_error != std::errc())
+    {
+      return false;
+    }
+    begin = y_end;
+    skip_spaces();
+    return begin == end;
+  }
+}
+
+SimulationScenario ReadScenarioCSV(const std::string &csv_path)
+{
+  MappedFile file(csv_path);
+  const char *data = reinterpret_cast<const char *>(file.Data());
+  size_t size = file.Size();
+
+  // chunks are cut after line breaks, so every line belongs to exactly one chunk
+  std::vector<CsvChunk> chunks(ChunkCount(size, size_t{1} << 20));
+  const char *chunk_begin = data;
+  for (size_t c = 0; c < chunks.size(); ++c)
+  {
+    const char *chunk_end = data + size;
+    if (c + 1 < chunks.size())
+    {
+      chunk_end = std::max(chunk_begin, data + size * (c + 1) / chunks.size());
+      const char *eol = static_cast<const char *>(std::memchr(chunk_end, '\n', data + size - chunk_end));
+      chunk_end = eol ? eol + 1 : data + size;
+    }
+    chunks[c].begin = chunk_begin;
+    chunks[c].end = chunk_end;
+    chunk_begin = chunk_end;
+  }
+
+  ParallelChunks(chunks.size(), chunks.size(), [&](size_t, size_t begin, size_t end)
+                 {
+                   for (size_t c = begin; c < end; ++c)
+                   {
+                     CsvChunk &chunk = chunks[c];
+                     ForEachLine(chunk.begin, chunk.end, [&](const char *line, const char *eol)
+                                 {
+                                   ++chunk.line_num;
+                                   chunk.target_num += StartsWith(line, eol, kTargetPrefix);
+                                   chunk.sensor_num += StartsWith(line, eol, kSensorPrefix);
+                                 });
+                   }
+                 });
+
+  size_t target_num = 0;
+  size_t sensor_num = 0;
+  for (const CsvChunk &chunk : chunks)
+  {
+    target_num += chunk.target_num;
+    sensor_num += chunk.sensor_num;
+  }
+  SimulationScenario scenario;
+  scenario.target_positions.resize(target_num);
+  scenario.sensor_positions.resize(sensor_num);
+
+  ParallelChunks(chunks.size(), chunks.size(), [&](size_t, size_t begin, size_t end)
+                 {
+                   // offsets of the first line and positions of the chunk
+                   size_t line_idx = 0, target_idx = 0, sensor_idx = 0;
+                   for (size_t c = 0; c < begin; ++c)
+                   {
+                     line_idx += chunks[c].line_num;
+                     target_idx += chunks[c].target_num;
+                     sensor_idx += chunks[c].sensor_num;
+                   }
+                   for (size_t c = begin; c < end; ++c)
+                   {
+                     ForEachLine(chunks[c].begin, chunks[c].end, [&](const char *line, const char *eol)
+                                 {
+                                   bool valid = true;
+                                   if (StartsWith(line, eol, kTargetPrefix))
+                                   {
+                                     valid = ParseCoordinates(line + kTargetPrefix.size(), eol, scenario.target_positions[target_idx++]);
+                                   }
+                                   else if (StartsWith(line, eol, kSensorPrefix))
+                                   {
+                                     valid = ParseCoordinates(line + kSensorPrefix.size(), eol, scenario.sensor_positions[sensor_idx++]);
+                                   }
+                                   else if (!IsBlank(line, eol) && line_idx != 0)
+                                   {
+                                     throw std::runtime_error("CSV line " + std::to_string(line_idx + 1) + " of " + csv_path + " does not start with 'target,' or 'sensor,'.");
+                                   }
+                                   if (!valid)
+                                   {
+                                     throw std::runtime_error("CSV line " + std::to_string(line_idx + 1) + " of " + csv_path + " is not a valid position.");
+                                   }
+                                   ++line_idx;
+                                 });
+                   }
+                 });
+  return scenario;
+}
@@ -0,0 +1,33 @@
+#include "api/HistoryArrays.hpp"
+
+void HistoryArrays::Append(const SimulationState &state)
+{
+  if (ticks_.empty())
+  {
+    sensor_num_ = state.sensor_states.size();
+    target_num_ = state.is_target_covered.size();
+  }
+  if (state.sensor_states.size() != sensor_num_ || state.sensor_battery_lvls.size() != sensor_num_ || state.is_target_covered.size() != target_num_)
+  {
+    throw std::runtime_error("State does not match the dimensions of the stored arrays");
+  }
+  ticks_.emplace_back(state.tick);
+  covered_target_counts_.emplace_back(state.covered_target_count);
+  coverage_percentages_.emplace_back(state.coverage_percentage);
+  for (Sensor::State sensor_state : state.sensor_states)
+  {
+    sensor_states_.emplace_back(static_cast<uint8_t>(sensor_state));
+  }
+  sensor_battery_lvls_.insert(sensor_battery_lvls_.end(), state.sensor_battery_lvls.begin(), state.sensor_battery_lvls.end());
+  is_target_covered_.insert(is_target_covered_.end(), state.is_target_covered.begin(), state.is_target_covered.end());
+}
+
+void HistoryArrays::Reserve(size_t tick_count, size_t sensor_num, size_t target_num)
+{
+  ticks_.reserve(tick_count);
+  covered_target_counts_.reserve(tick_count);
+  coverage_percentages_.reserve(tick_count);
+  sensor_states_.reserve(tick_count * sensor_num);
+  sensor_battery_lvls_.reserve(tick_count * sensor_num);
+  is_target_covered_.reserve(tick_count * target_num);
+}
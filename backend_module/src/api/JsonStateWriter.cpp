@@ -0,0 +1,167 @@
+#include "api/JsonStateWriter.hpp"
+
+#include <charconv>
+#include <cmath>
+
+/**
+ * @brief Size of buffered text at which it is handed to the stream.
+ */
+static constexpr size_t kFlushThreshold = size_t{1} << 20;
+
+/**
+ * @brief Appends an integer to a string.
+ */
+template <typename T>
+static void AppendInteger(std::string &out, T value)
+{
+  char buffer[24];
+  auto [end, _] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, end);
+}
+
+/**
+ * @brief Appends a floating point number to a string, formatted like nlohmann::json.
+ */
+static void AppendFloat(std::string &out, double value)
+{
+  if (!std::isfinite(value))
+  {
+    out += "null";
+    return;
+  }
+  char buffer[64];
+  char *end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, end);
+}
+
+/**
+ * @brief Appends a line break followed by indentation, or nothing in compact mode.
+ */
+static void AppendNewline(std::string &out, int indent, int level)
+{
+  if (indent >= 0)
+  {
+    out += '\n';
+    out.append(static_cast<size_t>(indent) * level, ' ');
+  }
+}
+
+/**
+ * @brief Appends an array, formatted like nlohmann::json.
+ * @param append_element Function appending the i-th element.
+ */
+template <typename F>
+static void AppendArray(std::string &out, size_t size, int indent, int level, F &&append_element)
+{
+  if (size == 0)
+  {
+    out += "[]";
+    return;
+  }
+  out += '[';
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (i > 0)
+    {
+      out += ',';
+    }
+    AppendNewline(out, indent, level + 1);
+    append_element(i);
+  }
+  AppendNewline(out, indent, level);
+  out += ']';
+}
+
+/**
+ * @brief Gets the JSON name of a sensor state, the same as in NLOHMANN_JSON_SERIALIZE_ENUM.
+ */
+static const char *StateName(Sensor::State state)
+{
+  switch (state)
+  {
+  case Sensor::State::kOn:
+    return "\"kOn\"";
+  case Sensor::State::kOff:
+    return "\"kOff\"";
+  case Sensor::State::kDead:
+    return "\"kDead\"";
+  case Sensor::State::kUndecided:
+    return "\"kUndecided\"";
+  default:
+    return "\"kOn\""; // nlohmann maps unknown values to the first entry
+  }
+}
+
+void JsonStateWriter::AppendState(std::string &out, const SimulationState &state, int indent, int level)
+{
+  const char *separator = indent >= 0 ? "\": " : "\":";
+  bool first = true;
+  auto key = [&](const char *name)
+  {
+    if (!first)
+    {
+      out += ',';
+    }
+    first = false;
+    AppendNewline(out, indent, level + 1);
+    out += '"';
+    out += name;
+    out += separator;
+  };
+  // keys in alphabetical order, as stored by nlohmann::json
+  out += '{';
+  key("all_target_covered");
+  out += state.all_target_covered ? "true" : "false";
+  key("coverage_percentage");
+  AppendFloat(out, state.coverage_percentage);
+  key("covered_target_count");
+  AppendInteger(out, state.covered_target_count);
+  key("is_target_covered");
+  AppendArray(out, state.is_target_covered.size(), indent, level + 1, [&](size_t i)
+              { out += state.is_target_covered[i] ? "true" : "false"; });
+  key("sensor_battery_lvls");
+  AppendArray(out, state.sensor_battery_lvls.size(), indent, level + 1, [&](size_t i)
+              { AppendInteger(out, state.sensor_battery_lvls[i]); });
+  key("sensor_states");
+  AppendArray(out, state.sensor_states.size(), indent, level + 1, [&](size_t i)
+              { out += StateName(state.sensor_states[i]); });
+  key("tick");
+  AppendInteger(out, state.tick);
+  AppendNewline(out, indent, level);
+  out += '}';
+}
+
+void JsonStateWriter::Write(const SimulationState &state)
+{
+  buffer_ += state_count_ == 0 ? '[' : ',';
+  AppendNewline(buffer_, indent_, 1);
+  AppendState(buffer_, state, indent_, 1);
+  ++state_count_;
+  if (buffer_.size() >= kFlushThreshold)
+  {
+    Flush();
+  }
+}
+
+size_t JsonStateWriter::Close()
+{
+  size_t closing_begin = buffer_.size();
+  if (state_count_ == 0)
+  {
+    buffer_ += "[]";
+  }
+  else
+  {
+    AppendNewline(buffer_, indent_, 0);
+    buffer_ += ']';
+  }
+  size_t closing_size = buffer_.size() - closing_begin;
+  Flush();
+  return closing_size;
+}
+
+void JsonStateWriter::Flush()
+{
+  out_.write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
@@ -0,0 +1,93 @@
+#include "api/MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string &path)
+{
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error("Failed to open file: " + path);
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size))
+  {
+    CloseHandle(file);
+    throw std::runtime_error("Failed to get size of file: " + path);
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  if (size_ > 0)
+  {
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ != nullptr)
+    {
+      data_ = static_cast<const uint8_t *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+  }
+  CloseHandle(file); // the mapping keeps the file open
+  if (size_ > 0 && data_ == nullptr)
+  {
+    if (mapping_ != nullptr)
+    {
+      CloseHandle(mapping_);
+    }
+    throw std::runtime_error("Failed to map file: " + path);
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_ != nullptr)
+  {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr)
+  {
+    CloseHandle(mapping_);
+  }
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Failed to open file: " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0)
+  {
+    close(fd);
+    throw std::runtime_error("Failed to get size of file: " + path);
+  }
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ > 0)
+  {
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      close(fd);
+      throw std::runtime_error("Failed to map file: " + path);
+    }
+    data_ = static_cast<const uint8_t *>(data);
+  }
+  close(fd); // the mapping keeps the file open
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_ != nullptr)
+  {
+    munmap(const_cast<uint8_t *>(data_), size_);
+  }
+}
+#endif
@@ -0,0 +1,129 @@
+#include "api/ParameterSweep.hpp"
+
+#include <atomic>
+#include <deque>
+#include <map>
+
+#include "api/SimulationManager.hpp"
+#include "core/ThreadPool.hpp"
+
+std::vector<SimulationParameters> ExpandSweepGrid(const SweepGrid &grid)
+{
+  if (grid.sensor_radii.empty() || grid.initial_battery_lvls.empty() || grid.reshuffle_intervals.empty() ||
+      grid.max_ticks.empty() || grid.stop_conditions.empty() || grid.stop_thresholds.empty())
+  {
+    throw std::runtime_error("Every parameter of a sweep grid needs at least one value");
+  }
+  size_t variant_num = grid.sensor_radii.size() * grid.initial_battery_lvls.size() * grid.reshuffle_intervals.size() *
+                       grid.max_ticks.size() * grid.stop_conditions.size() * grid.stop_thresholds.size();
+  std::vector<SimulationParameters> variants;
+  variants.reserve(variant_num);
+  for (size_t k = 0; k < variant_num; ++k)
+  {
+    // k is a mixed-radix number, its lowest digit picks the stop threshold
+    size_t rest = k;
+    auto pick = [&rest](const auto &values)
+    {
+      auto value = values[rest % values.size()];
+      rest /= values.size();
+      return value;
+    };
+    float threshold = pick(grid.stop_thresholds);
+    SimulationStopCondition condition = pick(grid.stop_conditions);
+    uint32_t max_ticks = pick(grid.max_ticks);
+    uint32_t interval = pick(grid.reshuffle_intervals);
+    uint32_t battery_lvl = pick(grid.initial_battery_lvls);
+    double radius = pick(grid.sensor_radii);
+    variants.emplace_back(radius, battery_lvl, interval, condition, threshold, max_ticks);
+  }
+  return variants;
+}
+
+ParameterSweep::ParameterSweep(SimulationScenario scenario, std::vector<SimulationParameters> variants, SpatialOrdering ordering, uint32_t thread_num)
+    : scenario_(std::move(scenario)), variants_(std::move(variants)), ordering_(ordering), thread_num_(thread_num)
+{
+  SimulationManager::ValidateScenario(scenario_);
+  if (variants_.empty())
+  {
+    throw std::runtime_error("Sweep must contain at least one variant");
+  }
+  for (const auto &parameters : variants_)
+  {
+    SimulationManager::ValidateParameters(parameters);
+  }
+}
+
+std::vector<SweepResult> ParameterSweep::Run(TaskControl *control) const
+{
+  std::vector<SweepResult> results(variants_.size());
+  std::map<double, std::vector<uint32_t>> variants_by_radius;
+  for (uint32_t v = 0; v < variants_.size(); ++v)
+  {
+    results[v].variant = v;
+    results[v].parameters = variants_[v];
+    variants_by_radius[variants_[v].sensor_radius].emplace_back(v);
+  }
+  std::atomic<size_t> finished = 0;
+  auto report_progress = [&](size_t n)
+  {
+    if (control)
+    {
+      control->SetProgress(static_cast<float>(finished.fetch_add(n) + n) / variants_.size());
+    }
+  };
+
+  std::deque<Simulation> templates; // stable addresses while forks are taken from them, and outlives the pool
+  ThreadPool pool(thread_num_);
+  for (const auto &[radius, group] : variants_by_radius)
+  {
+    if (control && control->IsCancelled())
+    {
+      break;
+    }
+    try
+    {
+      templates.emplace_back().Initialize(variants_[group.front()], scenario_, ordering_);
+    }
+    catch (const std::exception &e)
+    {
+      for (uint32_t v : group)
+      {
+        results[v].failed = true;
+        results[v].error = e.what();
+      }
+      templates.pop_back();
+      report_progress(group.size());
+      continue;
+    }
+    const Simulation *base = &templates.back();
+    for (uint32_t v : group)
+    {
+      pool.Submit([&, base, v]()
+                  {
+                    if (control && control->IsCancelled())
+                    {
+                      return;
+                    }
+                    const SimulationParameters &parameters = variants_[v];
+                    SweepResult &result = results[v];
+                    Simulation simulation = base->Fork(parameters);
+                    RunSummary summary = SimulationManager::RunToEnd(simulation, parameters, 0, control);
+                    if (!summary.finished)
+                    {
+                      return;
+                    }
+                    result.lifetime = summary.lifetime;
+                    result.initial_coverage = summary.initial_coverage;
+                    result.final_coverage = summary.final_coverage;
+                    result.first_death_tick = summary.first_death_tick;
+                    result.min_coverage = summary.min_coverage;
+                    report_progress(1); });
+    }
+  }
+  pool.Wait();
+  if (control)
+  {
+    control->ThrowIfCancelled();
+  }
+  return results;
+}
@@ -0,0 +1,55 @@
+#include "api/PointFile.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+static_assert(std::endian::native == std::endian::little, "The point file format is little-endian");
+
+PointFile::PointFile(const std::string &path) : file_(path)
+{
+  PointFileHeader header;
+  if (file_.Size() < sizeof(header))
+  {
+    throw std::runtime_error("File is too small to be a point file: " + path);
+  }
+  std::memcpy(&header, file_.Data(), sizeof(header));
+  if (std::memcmp(header.magic, PointFileHeader::kMagic, sizeof(header.magic)) != 0)
+  {
+    throw std::runtime_error("File is not a point file: " + path);
+  }
+  if (header.version != PointFileHeader::kVersion)
+  {
+    throw std::runtime_error("Unsupported point file version " + std::to_string(header.version) + ": " + path);
+  }
+  uint64_t max_points = (file_.Size() - sizeof(header)) / sizeof(Point);
+  if (header.target_num > max_points || header.sensor_num > max_points - header.target_num)
+  {
+    throw std::runtime_error("Point file is truncated: " + path);
+  }
+  // the mapping is page aligned and the header keeps the positions 8 byte aligned
+  const Point *points = reinterpret_cast<const Point *>(file_.Data() + sizeof(header));
+  positions_ = ScenarioView({points, header.target_num}, {points + header.target_num, header.sensor_num});
+}
+
+void WritePointFile(const std::string &path, ScenarioView scenario)
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Failed to open file for writing: " + path);
+  }
+  PointFileHeader header{};
+  std::memcpy(header.magic, PointFileHeader::kMagic, sizeof(header.magic));
+  header.version = PointFileHeader::kVersion;
+  header.target_num = scenario.target_positions.size();
+  header.sensor_num = scenario.sensor_positions.size();
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(scenario.target_positions.data()), scenario.target_positions.size_bytes());
+  file.write(reinterpret_cast<const char *>(scenario.sensor_positions.data()), scenario.sensor_positions.size_bytes());
+  file.flush();
+  if (!file)
+  {
+    throw std::runtime_error("Failed to write point file: " + path);
+  }
+}
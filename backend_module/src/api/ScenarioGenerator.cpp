@@ -0,0 +1,465 @@
+#include "api/ScenarioGenerator.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <numbers>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+
+#include "core/parallel.hpp"
+#include "core/utility.hpp"
+#include "core/cover_structures.hpp"
+
+namespace
+{
+  /**
+   * @brief Independent random streams, one per purpose.
+   */
+  enum Stream : uint64_t
+  {
+    kTargets,
+    kSensors,
+    kCenters,
+    kTargetDarts,
+    kSensorDarts,
+    kTargetShuffle,
+    kSensorShuffle,
+  };
+
+  /**
+   * @brief Scrambles a 64-bit value, the output function of SplitMix64.
+   */
+  constexpr uint64_t Mix64(uint64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  /**
+   * @class SplitMix64
+   * @brief Small and fast random generator. Every (seed, stream, index) triple starts an unrelated sequence,
+   * so any point can be drawn without drawing the points before it.
+   */
+  class SplitMix64
+  {
+    uint64_t state_; ///< The current state.
+
+  public:
+    SplitMix64(uint64_t seed, Stream stream, uint64_t index) : state_(Mix64(Mix64(seed ^ Mix64(stream + 1)) + index)) {}
+    uint64_t Next() { return Mix64(state_ += 0x9E3779B97F4A7C15ull); } ///< Draws 64 random bits.
+    double Uniform() { return (Next() >> 11) * 0x1.0p-53; }             ///< Draws a number uniformly from [0, 1).
+    double Normal()                                                     ///< Draws a number from the standard normal distribution.
+    {
+      double u1 = 1.0 - Uniform(); // in (0, 1], so the logarithm is finite
+      double u2 = Uniform();
+      return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2);
+    }
+  };
+
+  /**
+   * @brief Throws darts at a background grid until no more points fit at the minimum distance.
+   * @details Cells have a side of min_distance / sqrt(2), so each holds at most one point and conflicts lie
+   * within two cells. Cells are visited in 9 phases of cells three apart, which cannot conflict with each other,
+   * so the rows of a phase are processed in parallel. Every cell draws its darts from its own stream.
+   * Empty cells hold NaN, which fails every distance comparison, so the conflict test needs no branches.
+   * Later rounds mostly hit covered space, so they are skipped once enough points are placed.
+   * @param min_distance The minimum distance between points.
+   * @param seed The seed of the scenario.
+   * @param stream The stream of the darts.
+   * @param wanted The number of points after which no further round is started.
+   * @return The points, in cell order.
+   */
+  std::vector<Point> PoissonDiskPool(double min_distance, uint64_t seed, Stream stream, size_t wanted)
+  {
+    constexpr int kRounds = 4;
+    constexpr int kAttempts = 3;
+    const double cell = min_distance / std::numbers::sqrt2;
+    if (std::ceil(1.0 / cell) > 8192)
+    {
+      throw std::runtime_error("Minimum distance " + std::to_string(min_distance) + " is too small for the Poisson disk layout");
+    }
+    const int64_t side = static_cast<int64_t>(std::ceil(1.0 / cell));
+    const double d2 = Sqr(min_distance);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<Point> grid(side * side, Point(nan, nan));
+    auto fits = [&](const Point &p, int64_t x, int64_t y)
+    {
+      bool conflict = false;
+      for (int64_t ny = std::max<int64_t>(y - 2, 0); ny <= std::min(y + 2, side - 1); ++ny)
+      {
+        for (int64_t nx = std::max<int64_t>(x - 2, 0); nx <= std::min(x + 2, side - 1); ++nx)
+        {
+          const Point &q = grid[ny * side + nx];
+          conflict |= Sqr(q.x - p.x) + Sqr(q.y - p.y) < d2;
+        }
+      }
+      return !conflict;
+    };
+    std::atomic<size_t> placed = 0;
+    for (int round = 0; round < kRounds && placed < wanted; ++round)
+    {
+      for (int64_t phase = 0; phase < 9; ++phase)
+      {
+        const int64_t px = phase % 3, py = phase / 3;
+        const size_t row_num = static_cast<size_t>(std::max<int64_t>(side - py + 2, 0) / 3);
+        ParallelChunks(row_num, ChunkCount(row_num, 16), [&](size_t, size_t begin, size_t end)
+                       {
+                         size_t chunk_placed = 0;
+                         for (size_t r = begin; r < end; ++r)
+                         {
+                           int64_t y = py + 3 * static_cast<int64_t>(r);
+                           for (int64_t x = px; x < side; x += 3)
+                           {
+                             int64_t c = y * side + x;
+                             if (!std::isnan(grid[c].x))
+                             {
+                               continue;
+                             }
+                             SplitMix64 rng(seed, stream, static_cast<uint64_t>(round * side * side + c));
+                             for (int attempt = 0; attempt < kAttempts; ++attempt)
+                             {
+                               Point p((x + rng.Uniform()) * cell, (y + rng.Uniform()) * cell);
+                               if (p.x < 1.0 && p.y < 1.0 && fits(p, x, y))
+                               {
+                                 grid[c] = p;
+                                 ++chunk_placed;
+                                 break;
+                               }
+                             }
+                           }
+                         }
+                         placed += chunk_placed; });
+      }
+    }
+    std::vector<Point> pool;
+    for (const Point &p : grid)
+    {
+      if (!std::isnan(p.x))
+      {
+        pool.emplace_back(p);
+      }
+    }
+    return pool;
+  }
+
+  /**
+   * @class CandidateSource
+   * @brief Candidate positions of one kind of entity, drawn by index.
+   * @details The first count candidates form the scenario. Later ones replace candidates rejected by the neighborhood limit.
+   */
+  class CandidateSource
+  {
+    const ScenarioGeneratorOptions &options_; ///< The layout and its settings.
+    Stream stream_;                           ///< The stream of independently drawn candidates.
+    uint32_t count_;                          ///< The number of requested positions.
+    const std::vector<Point> &centers_;       ///< kGaussianMixture: the cluster centers.
+    double max_radius_ = 0.0;                 ///< kRadial: the bound of the uniformly drawn radius.
+    uint32_t cols_ = 1;                       ///< kJitteredGrid: the number of columns.
+    uint32_t rows_ = 1;                       ///< kJitteredGrid: the number of rows.
+    std::vector<Point> pool_;                 ///< kPoissonDisk: all points that fit, in random order.
+
+  public:
+    /**
+     * @brief Prepares the candidates.
+     * @param options The layout, its settings and the seed.
+     * @param sensors Whether the candidates are sensors or targets.
+     * @param count The number of requested positions.
+     * @param centers The cluster centers of kGaussianMixture.
+     */
+    CandidateSource(const ScenarioGeneratorOptions &options, bool sensors, uint32_t count, const std::vector<Point> &centers)
+        : options_(options), stream_(sensors ? kSensors : kTargets), count_(count), centers_(centers)
+    {
+      max_radius_ = sensors ? 0.6 : 0.4; // as in generate_positions.py
+      if (count == 0)
+      {
+        return;
+      }
+      cols_ = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+      rows_ = (count + cols_ - 1) / cols_;
+      if (options.layout == ScenarioLayout::kPoissonDisk)
+      {
+        Stream darts = sensors ? kSensorDarts : kTargetDarts;
+        if (options.min_distance > 0.0)
+        {
+          pool_ = PoissonDiskPool(options.min_distance, options.seed, darts, count);
+        }
+        else
+        {
+          // random packings reach about 0.7 / d^2 points, aim above count and shrink while too few fit
+          for (double d = std::sqrt(0.5 / count); pool_.size() < count; d *= 0.9)
+          {
+            pool_ = PoissonDiskPool(d, options.seed, darts, count);
+          }
+        }
+        if (pool_.size() < count)
+        {
+          throw std::runtime_error("Only " + std::to_string(pool_.size()) + " points fit at minimum distance " +
+                                   std::to_string(options.min_distance) + ", " + std::to_string(count) + " requested");
+        }
+        SplitMix64 rng(options.seed, sensors ? kSensorShuffle : kTargetShuffle, 0);
+        for (size_t i = pool_.size() - 1; i > 0; --i)
+        {
+          std::swap(pool_[i], pool_[rng.Next() % (i + 1)]);
+        }
+      }
+    }
+
+    /**
+     * @brief Checks if a candidate exists. Only the Poisson disk layout runs out of candidates.
+     */
+    bool Has(uint64_t index) const
+    {
+      return options_.layout != ScenarioLayout::kPoissonDisk || index < pool_.size();
+    }
+
+    /**
+     * @brief Draws a candidate.
+     * @param index The index of the candidate, for which Has must hold.
+     * @return The position.
+     */
+    Point operator()(uint64_t index) const
+    {
+      SplitMix64 rng(options_.seed, stream_, index);
+      switch (options_.layout)
+      {
+      case ScenarioLayout::kRadial:
+      {
+        double radius = 0.7 * std::pow(rng.Uniform() * max_radius_, 0.8);
+        double angle = rng.Uniform() * 2.0 * std::numbers::pi;
+        return Point(radius * std::cos(angle) / 2 + 0.5, radius * std::sin(angle) / 2 + 0.5);
+      }
+      case ScenarioLayout::kGaussianMixture:
+      {
+        const Point &center = centers_[rng.Next() % centers_.size()];
+        Point p;
+        for (int attempt = 0; attempt < 64; ++attempt)
+        {
+          p = Point(center.x + options_.cluster_spread * rng.Normal(), center.y + options_.cluster_spread * rng.Normal());
+          if (p.x >= 0.0 && p.x < 1.0 && p.y >= 0.0 && p.y < 1.0)
+          {
+            return p;
+          }
+        }
+        return Point(std::clamp(p.x, 0.0, 1.0), std::clamp(p.y, 0.0, 1.0));
+      }
+      case ScenarioLayout::kJitteredGrid:
+      {
+        uint64_t cell = index % count_; // replacements revisit the cells in order
+        double cx = static_cast<double>(cell % cols_) + 0.5 + options_.jitter * (rng.Uniform() - 0.5);
+        double cy = static_cast<double>(cell / cols_) + 0.5 + options_.jitter * (rng.Uniform() - 0.5);
+        return Point(cx / cols_, cy / rows_);
+      }
+      case ScenarioLayout::kPoissonDisk:
+        return pool_[index];
+      case ScenarioLayout::kUniform:
+      default:
+      {
+        double x = rng.Uniform();
+        return Point(x, rng.Uniform());
+      }
+      }
+    }
+
+    /**
+     * @brief Draws the first count candidates in parallel.
+     * @return The positions.
+     */
+    std::vector<Point> First() const
+    {
+      std::vector<Point> positions(count_);
+      ParallelChunks(count_, ChunkCount(count_), [&](size_t, size_t begin, size_t end)
+                     {
+                       for (size_t i = begin; i < end; ++i)
+                       {
+                         positions[i] = (*this)(i);
+                       } });
+      return positions;
+    }
+
+    uint32_t GetCount() const { return count_; } ///< Gets the number of requested positions.
+  };
+
+  /**
+   * @class NeighborhoodFilter
+   * @brief Accepts positions as long as no sensor exceeds bit_vec_size sensors or targets within the radius.
+   * @details Accepted sensors are bucketed in a grid with cells not smaller than the radius.
+   * Ranges are tested like in SpatialGrid, so the counts match the neighborhoods built by the simulation.
+   */
+  class NeighborhoodFilter
+  {
+    double radius2_;                           ///< The squared radius.
+    int64_t side_;                             ///< The number of cells along each axis of the unit square.
+    double cell_size_;                         ///< The side of a cell.
+    std::vector<std::vector<uint32_t>> cells_; ///< Indices of accepted sensors, per cell.
+    std::vector<Point> sensors_;               ///< Positions of accepted sensors.
+    std::vector<uint8_t> sensor_counts_;       ///< Number of other sensors within the radius of every accepted sensor.
+    std::vector<uint8_t> target_counts_;       ///< Number of targets within the radius of every accepted sensor.
+    std::vector<uint32_t> neighbors_;          ///< Sensors found by the last query.
+
+  public:
+    NeighborhoodFilter(double radius, uint32_t sensor_num) : radius2_(Sqr(radius))
+    {
+      // cells are at least as large as the radius, but not more numerous than the sensors
+      side_ = static_cast<int64_t>(std::clamp(std::min(std::floor(1.0 / radius), std::ceil(std::sqrt(static_cast<double>(sensor_num)))), 1.0, 65536.0));
+      cell_size_ = 1.0 / side_;
+      cells_.resize(side_ * side_);
+    }
+
+    /**
+     * @brief Accepts a sensor if neither it nor any sensor in range would have too many sensors in range.
+     * @return True if the sensor was accepted.
+     */
+    bool TryAddSensor(const Point &p)
+    {
+      FindSensors(p);
+      if (neighbors_.size() > bit_vec_size)
+      {
+        return false;
+      }
+      for (uint32_t n : neighbors_)
+      {
+        if (sensor_counts_[n] == bit_vec_size)
+        {
+          return false;
+        }
+      }
+      for (uint32_t n : neighbors_)
+      {
+        ++sensor_counts_[n];
+      }
+      cells_[Cell(p.y) * side_ + Cell(p.x)].emplace_back(static_cast<uint32_t>(sensors_.size()));
+      sensors_.emplace_back(p);
+      sensor_counts_.emplace_back(static_cast<uint8_t>(neighbors_.size()));
+      target_counts_.emplace_back(0);
+      return true;
+    }
+
+    /**
+     * @brief Accepts a target if no sensor in range would have too many targets in range.
+     * @return True if the target was accepted.
+     */
+    bool TryAddTarget(const Point &p)
+    {
+      FindSensors(p);
+      for (uint32_t n : neighbors_)
+      {
+        if (target_counts_[n] == bit_vec_size)
+        {
+          return false;
+        }
+      }
+      for (uint32_t n : neighbors_)
+      {
+        ++target_counts_[n];
+      }
+      return true;
+    }
+
+  private:
+    /**
+     * @brief Gets the cell coordinate of a coordinate, clamped to the grid.
+     */
+    int64_t Cell(double v) const
+    {
+      return static_cast<int64_t>(std::clamp(std::floor(v / cell_size_), 0.0, static_cast<double>(side_ - 1)));
+    }
+
+    /**
+     * @brief Collects the accepted sensors strictly closer to a position than the radius into neighbors_.
+     */
+    void FindSensors(const Point &p)
+    {
+      neighbors_.clear();
+      int64_t cx = Cell(p.x), cy = Cell(p.y);
+      for (int64_t y = std::max<int64_t>(cy - 1, 0); y <= std::min(cy + 1, side_ - 1); ++y)
+      {
+        for (int64_t x = std::max<int64_t>(cx - 1, 0); x <= std::min(cx + 1, side_ - 1); ++x)
+        {
+          for (uint32_t s : cells_[y * side_ + x])
+          {
+            if (Sqr(sensors_[s].x - p.x) + Sqr(sensors_[s].y - p.y) < radius2_)
+            {
+              neighbors_.emplace_back(s);
+            }
+          }
+        }
+      }
+    }
+  };
+
+  /**
+   * @brief Takes candidates in order, skipping those rejected by a filter, until enough are accepted.
+   * @param source The candidates.
+   * @param accept The filter, called once per candidate.
+   * @param name The name of the entities used in the error message.
+   * @return The accepted positions.
+   * @throws std::runtime_error if too many candidates are rejected.
+   */
+  template <typename F>
+  std::vector<Point> Filter(const CandidateSource &source, F &&accept, const std::string &name)
+  {
+    const uint32_t count = source.GetCount();
+    const uint64_t max_candidates = 8 * uint64_t{count} + 1024;
+    std::vector<Point> batch = source.First(); // most candidates are accepted, so they are still drawn in parallel
+    std::vector<Point> positions;
+    positions.reserve(count);
+    for (uint64_t index = 0; positions.size() < count; ++index)
+    {
+      if (!source.Has(index) || index == max_candidates)
+      {
+        throw std::runtime_error("Could only place " + std::to_string(positions.size()) + " of " + std::to_string(count) + " " + name +
+                                 " without exceeding " + std::to_string(bit_vec_size) + " neighbors of a sensor, lower the density or the neighborhood radius");
+      }
+      Point p = index < batch.size() ? batch[index] : source(index);
+      if (accept(p))
+      {
+        positions.emplace_back(p);
+      }
+    }
+    return positions;
+  }
+}
+
+SimulationScenario GenerateScenario(uint32_t target_num, uint32_t sensor_num, const ScenarioGeneratorOptions &options)
+{
+  if (options.layout == ScenarioLayout::kGaussianMixture && (options.cluster_num == 0 || !(options.cluster_spread > 0.0)))
+  {
+    throw std::runtime_error("Gaussian mixture needs at least one cluster and a positive spread");
+  }
+  if (!(options.jitter >= 0.0 && options.jitter <= 1.0))
+  {
+    throw std::runtime_error("Jitter must be between 0 and 1");
+  }
+  if (!(options.min_distance >= 0.0) || !(options.neighborhood_radius >= 0.0))
+  {
+    throw std::runtime_error("Minimum distance and neighborhood radius must not be negative");
+  }
+
+  std::vector<Point> centers;
+  if (options.layout == ScenarioLayout::kGaussianMixture)
+  {
+    for (uint32_t c = 0; c < options.cluster_num; ++c)
+    {
+      SplitMix64 rng(options.seed, kCenters, c);
+      double x = rng.Uniform();
+      centers.emplace_back(x, rng.Uniform());
+    }
+  }
+  CandidateSource targets(options, false, target_num, centers);
+  CandidateSource sensors(options, true, sensor_num, centers);
+  if (options.neighborhood_radius == 0.0)
+  {
+    return SimulationScenario(targets.First(), sensors.First());
+  }
+
+  // sensors first, so that targets only need to respect the target limit of the final sensors
+  NeighborhoodFilter filter(options.neighborhood_radius, sensor_num);
+  std::vector<Point> sensor_positions = Filter(sensors, [&](const Point &p)
+                                               { return filter.TryAddSensor(p); }, "sensors");
+  std::vector<Point> target_positions = Filter(targets, [&](const Point &p)
+                                               { return filter.TryAddTarget(p); }, "targets");
+  return SimulationScenario(std::move(target_positions), std::move(sensor_positions));
+}
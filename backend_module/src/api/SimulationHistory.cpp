@@ -0,0 +1,169 @@
+#include "api/SimulationHistory.hpp"
+
+/**
+ * @brief Checks whether a sensor spent the tick turned on, given its state before and after the tick.
+ * @details A sensor that died during the tick was turned on until its battery ran out.
+ */
+static bool ConsumedBattery(Sensor::State before, Sensor::State after)
+{
+  return after == Sensor::State::kOn || (after == Sensor::State::kDead && before != Sensor::State::kDead);
+}
+
+SimulationHistory::SimulationHistory(uint32_t keyframe_interval) : keyframe_interval_(keyframe_interval)
+{
+  if (keyframe_interval_ == 0)
+  {
+    throw std::runtime_error("Keyframe interval must be greater than 0");
+  }
+}
+
+void SimulationHistory::Record(const SimulationState &state)
+{
+  AppendRecord(state);
+  last_.sensor_states = state.sensor_states;
+  last_.sensor_battery_lvls = state.sensor_battery_lvls;
+  last_.is_target_covered = state.is_target_covered;
+}
+
+void SimulationHistory::Push(SimulationState &&state)
+{
+  AppendRecord(state);
+  last_.sensor_states.swap(state.sensor_states);
+  last_.sensor_battery_lvls.swap(state.sensor_battery_lvls);
+  last_.is_target_covered.swap(state.is_target_covered);
+}
+
+void SimulationHistory::AppendRecord(const SimulationState &state)
+{
+  if (records_.empty())
+  {
+    sensor_num_ = state.sensor_states.size();
+    target_num_ = state.is_target_covered.size();
+  }
+  if (state.sensor_states.size() != sensor_num_ || state.sensor_battery_lvls.size() != sensor_num_ || state.is_target_covered.size() != target_num_)
+  {
+    throw std::runtime_error("State does not match the dimensions of the recorded history");
+  }
+  if (records_.size() % keyframe_interval_ == 0)
+  {
+    keyframes_.emplace_back(state);
+  }
+  else
+  {
+    for (uint32_t i = 0; i < sensor_num_; ++i)
+    {
+      Sensor::State before = last_.sensor_states[i];
+      Sensor::State after = state.sensor_states[i];
+      if (before != after)
+      {
+        changes_.emplace_back(i, after);
+      }
+      int32_t derived = last_.sensor_battery_lvls[i] - ConsumedBattery(before, after);
+      if (derived != state.sensor_battery_lvls[i])
+      {
+        fixes_.emplace_back(i, state.sensor_battery_lvls[i]);
+      }
+    }
+    for (uint32_t i = 0; i < target_num_; ++i)
+    {
+      if (last_.is_target_covered[i] != state.is_target_covered[i])
+      {
+        flips_.emplace_back(i);
+      }
+    }
+  }
+  records_.emplace_back(state.tick, state.covered_target_count, changes_.size(), flips_.size(), fixes_.size());
+}
+
+SimulationState SimulationHistory::GetStateAt(uint32_t tick) const
+{
+  // ticks are recorded in increasing order, usually consecutive
+  auto it = std::lower_bound(records_.begin(), records_.end(), tick, [](const TickRecord &record, uint32_t t)
+                             { return record.tick < t; });
+  if (it == records_.end() || it->tick != tick)
+  {
+    throw std::runtime_error("No state recorded at tick " + std::to_string(tick));
+  }
+  return Rebuild(it - records_.begin());
+}
+
+std::vector<SimulationState> SimulationHistory::GetStates() const
+{
+  std::vector<SimulationState> states;
+  states.reserve(records_.size());
+  ForEachState([&](const SimulationState &state)
+               { states.emplace_back(state); });
+  return states;
+}
+
+void SimulationHistory::Clear()
+{
+  records_.clear();
+  changes_.clear();
+  flips_.clear();
+  fixes_.clear();
+  keyframes_.clear();
+  last_ = SimulationState();
+  sensor_num_ = 0;
+  target_num_ = 0;
+}
+
+size_t SimulationHistory::MemoryUsage() const
+{
+  size_t keyframe_size = sensor_num_ * (sizeof(Sensor::State) + sizeof(int32_t)) + target_num_ / 8;
+  return records_.size() * sizeof(TickRecord) +
+         changes_.size() * sizeof(StateChange) +
+         flips_.size() * sizeof(uint32_t) +
+         fixes_.size() * sizeof(BatteryFix) +
+         keyframes_.size() * (sizeof(SimulationState) + keyframe_size);
+}
+
+SimulationState SimulationHistory::Rebuild(size_t index) const
+{
+  size_t keyframe = index / keyframe_interval_;
+  SimulationState state = keyframes_[keyframe];
+  for (size_t i = keyframe * keyframe_interval_ + 1; i <= index; ++i)
+  {
+    Apply(state, i);
+  }
+  return state;
+}
+
+void SimulationHistory::Apply(SimulationState &state, size_t index) const
+{
+  const TickRecord &previous = records_[index - 1];
+  const TickRecord &record = records_[index];
+  for (size_t k = previous.changes_end; k < record.changes_end; ++k)
+  {
+    const auto &[sensor, after] = changes_[k];
+    if (after == Sensor::State::kDead)
+    {
+      --state.sensor_battery_lvls[sensor]; // state changed, so the sensor was not dead before
+    }
+    state.sensor_states[sensor] = after;
+  }
+  for (size_t i = 0; i < sensor_num_; ++i)
+  {
+    if (state.sensor_states[i] == Sensor::State::kOn)
+    {
+      --state.sensor_battery_lvls[i];
+    }
+  }
+  for (size_t k = previous.fixes_end; k < record.fixes_end; ++k)
+  {
+    state.sensor_battery_lvls[fixes_[k].sensor] = fixes_[k].battery_lvl;
+  }
+  for (size_t k = previous.flips_end; k < record.flips_end; ++k)
+  {
+    state.is_target_covered[flips_[k]].flip();
+  }
+  FillSummary(state, record);
+}
+
+void SimulationHistory::FillSummary(SimulationState &state, const TickRecord &record) const
+{
+  state.tick = record.tick;
+  state.covered_target_count = record.covered_target_count;
+  state.all_target_covered = record.covered_target_count == target_num_;
+  state.coverage_percentage = record.covered_target_count / (float)target_num_;
+}
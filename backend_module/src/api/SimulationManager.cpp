@@ -1,7 +1,25 @@
 #include "api/SimulationManager.hpp"
 
+#include <filesystem>
+
 // #define RD 0
 
+SimulationManager::~SimulationManager()
+{
+  if (task_)
+  {
+    task_->Cancel();
+    try
+    {
+      task_->Wait();
+    }
+    catch (...)
+    {
+      // the error belongs to the task, which may outlive the manager
+    }
+  }
+}
+
 const SimulationParameters &SimulationManager::GetParameters() const
 {
   if (!parameters_.has_value())
@@ -13,6 +31,12 @@ const SimulationParameters &SimulationManager::GetParameters() const
 
 const SimulationScenario &SimulationManager::GetScenario() const
 {
+  if (!scenario_.has_value() && scenario_file_)
+  {
+    ScenarioView positions = scenario_file_->GetPositions();
+    scenario_.emplace(std::vector<Point>(positions.target_positions.begin(), positions.target_positions.end()),
+                      std::vector<Point>(positions.sensor_positions.begin(), positions.sensor_positions.end()));
+  }
   if (!scenario_.has_value())
   {
     throw std::runtime_error("Scenario not set");
@@ -20,12 +44,33 @@ const SimulationScenario &SimulationManager::GetScenario() const
   return scenario_.value();
 }
 
+std::shared_ptr<HistoryArrays> SimulationManager::GetHistoryArrays() const
+{
+  EnsureIdle();
+  if (!arrays_ || arrays_->GetTickCount() != history_.Size())
+  {
+    auto arrays = std::make_shared<HistoryArrays>();
+    arrays->Reserve(history_.Size(), history_.GetSensorNum(), history_.GetTargetNum());
+    history_.ForEachState([&](const SimulationState &state)
+                          { arrays->Append(state); });
+    arrays_ = std::move(arrays);
+  }
+  return arrays_;
+}
+
 void SimulationManager::SetParameters(const SimulationParameters &parameters)
 {
+  EnsureIdle();
   if (parameters_.has_value() && is_initialized_)
   {
     throw std::runtime_error("Cannot set parameters after initialization");
   }
+  ValidateParameters(parameters);
+  parameters_ = parameters;
+}
+
+void SimulationManager::ValidateParameters(const SimulationParameters &parameters)
+{
   if(parameters.sensor_radius <= 0)
   {
     throw std::runtime_error("Sensor radius must be positive");
@@ -42,92 +87,424 @@ void SimulationManager::SetParameters(const SimulationParameters &parameters)
   {
     throw std::runtime_error("Stop threshold must be greater than 0");
   }
-  parameters_ = parameters;
 }
 
 void SimulationManager::SetScenario(const SimulationScenario &scenario)
 {
-  if (scenario_.has_value() && is_initialized_)
+  SetScenario(SimulationScenario(scenario));
+}
+
+void SimulationManager::SetScenario(SimulationScenario &&scenario)
+{
+  EnsureIdle();
+  if (HasScenario() && is_initialized_)
   {
     throw std::runtime_error("Cannot set scenario after initialization");
   }
-  if (scenario.target_positions.empty())
+  ValidateScenario(scenario);
+  scenario_ = std::move(scenario);
+  scenario_file_.reset();
+}
+
+void SimulationManager::SetScenario(const double *target_coords, size_t target_num, const double *sensor_coords, size_t sensor_num)
+{
+  SetScenario(SimulationScenario(PointsFromCoordinates(target_coords, target_num), PointsFromCoordinates(sensor_coords, sensor_num)));
+}
+
+void SimulationManager::SetSpatialOrdering(SpatialOrdering ordering)
+{
+  EnsureIdle();
+  if (is_initialized_)
   {
-    throw std::runtime_error("Scenario must contain at least one target");
+    throw std::runtime_error("Cannot set spatial ordering after initialization");
   }
-  if (scenario.sensor_positions.empty())
+  spatial_ordering_ = ordering;
+}
+
+void SimulationManager::SetStateSink(std::shared_ptr<StateSink> sink)
+{
+  EnsureIdle();
+  sink_ = std::move(sink);
+}
+
+void SimulationManager::LoadConfigFromJSON(const std::string &json_path)
+{
+  EnsureIdle();
+  auto config = ReadConfigJSON(json_path);
+  if (!config.parameters.has_value())
   {
-    throw std::runtime_error("Scenario must contain at least one sensor");
+    throw std::runtime_error("JSON does not contain 'parameters' field.");
+  }
+  if (!config.scenario.has_value())
+  {
+    throw std::runtime_error("JSON does not contain 'scenario' field.");
   }
-  scenario_ = scenario;
+  parameters_ = std::move(config.parameters);
+  scenario_ = std::move(config.scenario);
+  scenario_file_.reset();
 }
 
 void SimulationManager::LoadParametersFromJSON(const std::string &json_path)
 {
-  auto j = LoadJSON(json_path);
-  if (!j.contains("parameters"))
+  EnsureIdle();
+  auto config = ReadConfigJSON(json_path, true, false);
+  if (!config.parameters.has_value())
   {
     throw std::runtime_error("JSON does not contain 'parameters' field.");
   }
-  parameters_ = j.at("parameters").get<SimulationParameters>();
+  parameters_ = std::move(config.parameters);
 }
 
 void SimulationManager::LoadScenarioFromJSON(const std::string &json_path)
 {
-  auto j = LoadJSON(json_path);
-  if (!j.contains("scenario"))
+  EnsureIdle();
+  auto config = ReadConfigJSON(json_path, false, true);
+  if (!config.scenario.has_value())
   {
     throw std::runtime_error("JSON does not contain 'scenario' field.");
   }
-  scenario_ = j.at("scenario").get<SimulationScenario>();
+  scenario_ = std::move(config.scenario);
+  scenario_file_.reset();
+}
+
+void SimulationManager::LoadScenarioFromCSV(const std::string &csv_path)
+{
+  EnsureIdle();
+  SetScenario(ReadScenarioCSV(csv_path));
+}
+
+void SimulationManager::LoadScenarioFromBinary(const std::string &path)
+{
+  EnsureIdle();
+  if (HasScenario() && is_initialized_)
+  {
+    throw std::runtime_error("Cannot set scenario after initialization");
+  }
+  auto file = std::make_shared<const PointFile>(path);
+  ValidateScenario(file->GetPositions());
+  scenario_.reset();
+  scenario_file_ = std::move(file);
+}
+
+void SimulationManager::DumpScenarioToBinary(const std::string &path) const
+{
+  EnsureIdle();
+  WritePointFile(path, GetScenarioView());
+}
+
+void SimulationManager::SaveCheckpoint(const std::string &path)
+{
+  EnsureIdle();
+  if (!is_initialized_)
+  {
+    throw std::runtime_error("Simulation is not initialized");
+  }
+  ScenarioView scenario = GetScenarioView();
+  SimulationLayout layout = simulation_->GetLayout();
+  if (!layout_hash_)
+  {
+    layout_hash_ = HashLayout(scenario, layout);
+  }
+  std::string layout_path = LayoutFilePath(path, *layout_hash_);
+  if (!std::filesystem::exists(layout_path))
+  {
+    WriteLayoutFile(layout_path, scenario, layout);
+  }
+  Checkpoint checkpoint;
+  checkpoint.layout_hash = *layout_hash_;
+  checkpoint.parameters = *parameters_;
+  checkpoint.ordering = spatial_ordering_;
+  checkpoint.ticks_run = ticks_run_;
+  checkpoint.finished = is_finished_;
+  checkpoint.snapshot = simulation_->TakeSnapshot();
+  WriteCheckpoint(path, checkpoint);
+}
+
+void SimulationManager::LoadCheckpoint(const std::string &path)
+{
+  EnsureIdle();
+  Checkpoint checkpoint = ReadCheckpoint(path);
+  ValidateParameters(checkpoint.parameters);
+  SimulationScenario scenario;
+  SimulationLayout layout;
+  ReadLayoutFile(LayoutFilePath(path, checkpoint.layout_hash), checkpoint.layout_hash, scenario, layout);
+  if (layout.sensor_radius != checkpoint.parameters.sensor_radius)
+  {
+    throw std::runtime_error("Checkpoint parameters do not match its layout file: " + path);
+  }
+  Simulation simulation = Simulation::Restore(scenario, std::move(layout), checkpoint.snapshot);
+
+  parameters_ = checkpoint.parameters;
+  scenario_ = std::move(scenario);
+  scenario_file_.reset();
+  simulation_ = std::move(simulation);
+  history_.Clear();
+  arrays_.reset();
+  is_initialized_ = true;
+  is_finished_ = checkpoint.finished;
+  ticks_run_ = checkpoint.ticks_run;
+  spatial_ordering_ = checkpoint.ordering;
+  layout_hash_ = checkpoint.layout_hash;
 }
 
 void SimulationManager::DumpStatesToJSON(const std::string& json_path) const
 {
-  if (states_.empty())
+  EnsureIdle();
+  if (history_.Empty())
   {
     throw std::runtime_error("No simulation states to dump");
   }
-  nlohmann::json j = states_;
   std::ofstream file(json_path);
   if (!file.is_open())
   {
     throw std::runtime_error("Failed to open file for writing: " + json_path);
   }
-  file << std::setw(2) << j << '\n';
+  JsonStateWriter writer(file, 2);
+  history_.ForEachState([&](const SimulationState &state)
+                        { writer.Write(state); });
+  writer.Close();
+  file << '\n';
+}
+
+void SimulationManager::DumpStatesToBinary(const std::string &path) const
+{
+  EnsureIdle();
+  if (history_.Empty())
+  {
+    throw std::runtime_error("No simulation states to dump");
+  }
+  BinaryStateSink sink(path);
+  history_.ForEachState([&](const SimulationState &state)
+                        { sink.Append(state); });
+  sink.Flush();
 }
 
 void SimulationManager::LoadRandomScenario(uint32_t target_num, uint32_t sensor_num)
 {
-  scenario_ = SimulationScenario();
-  auto &target_positions = scenario_->target_positions;
-  auto &sensor_positions = scenario_->sensor_positions;
-  std::random_device rd;
+  ScenarioGeneratorOptions options;
 #ifdef RD
-  std::mt19937 gen(RD);
+  options.seed = RD;
 #else
-  std::mt19937 gen(rd());
+  options.seed = std::random_device{}();
 #endif
-  std::uniform_real_distribution<> dist(0.0, 1.0);
-  sensor_positions.reserve(sensor_num);
-  target_positions.reserve(target_num);
-  for (size_t i = 0; i < sensor_num; ++i)
+  LoadGeneratedScenario(target_num, sensor_num, options);
+}
+
+void SimulationManager::LoadGeneratedScenario(uint32_t target_num, uint32_t sensor_num, const ScenarioGeneratorOptions &options)
+{
+  EnsureIdle();
+  SetScenario(GenerateScenario(target_num, sensor_num, options));
+}
+
+void SimulationManager::Initialize()
+{
+  EnsureIdle();
+  CheckInitializable();
+  InitializeSimulation(nullptr);
+}
+
+void SimulationManager::Run()
+{
+  EnsureIdle();
+  Advance(std::numeric_limits<uint32_t>::max(), nullptr, nullptr);
+}
+
+RunSummary SimulationManager::RunSummarized()
+{
+  EnsureIdle();
+  CheckRunnable();
+  RunSummary summary = RunToEnd(*simulation_, *parameters_, ticks_run_);
+  ticks_run_ += summary.ticks_run;
+  is_finished_ = true;
+  return summary;
+}
+
+SimulationState SimulationManager::Step()
+{
+  return RunFor(1);
+}
+
+SimulationState SimulationManager::RunFor(uint32_t tick_num)
+{
+  EnsureIdle();
+  if (tick_num == 0)
   {
-    sensor_positions.emplace_back(dist(gen), dist(gen));
+    throw std::runtime_error("Number of ticks must be greater than 0");
   }
-  for (size_t i = 0; i < target_num; ++i)
+  SimulationState last;
+  Advance(tick_num, nullptr, &last);
+  return last;
+}
+
+SimulationState SimulationManager::RunUntil(const std::function<bool(const SimulationState &)> &predicate)
+{
+  EnsureIdle();
+  if (!predicate)
   {
-    target_positions.emplace_back(dist(gen), dist(gen));
+    throw std::runtime_error("Predicate not set");
   }
+  SimulationState last;
+  Advance(std::numeric_limits<uint32_t>::max(), predicate, &last);
+  return last;
 }
 
-void SimulationManager::Initialize()
+std::shared_ptr<SimulationTask> SimulationManager::InitializeAsync()
+{
+  EnsureIdle();
+  CheckInitializable();
+  task_ = std::make_shared<SimulationTask>([this](TaskControl &control)
+                                           { InitializeSimulation(&control); });
+  return task_;
+}
+
+std::shared_ptr<SimulationTask> SimulationManager::RunAsync()
+{
+  EnsureIdle();
+  CheckRunnable();
+  task_ = std::make_shared<SimulationTask>([this](TaskControl &control)
+                                           { Advance(std::numeric_limits<uint32_t>::max(), nullptr, nullptr, &control); });
+  return task_;
+}
+
+void SimulationManager::Reset()
+{
+  EnsureIdle();
+  parameters_.reset();
+  scenario_.reset();
+  scenario_file_.reset();
+  simulation_.reset();
+  history_.Clear();
+  arrays_.reset();
+  is_initialized_ = false;
+  is_finished_ = false;
+  ticks_run_ = 0;
+  task_.reset();
+  layout_hash_.reset();
+}
+
+bool SimulationManager::ShouldStop(const SimulationParameters &parameters, const SimulationState &state)
+{
+  switch (parameters.stop_condition)
+  {
+  case SimulationStopCondition::kManual:
+    return false;
+    break;
+  case SimulationStopCondition::kZeroCoverage:
+    return state.covered_target_count == 0;
+    break;
+  case SimulationStopCondition::kCoverageBelowThreshold:
+    return state.coverage_percentage < parameters.stop_threshold;
+    break;
+  case SimulationStopCondition::kAnyCoverageLost:
+    return !state.all_target_covered;
+    break;
+  default:
+    return false;
+    break;
+  }
+}
+
+RunSummary SimulationManager::RunToEnd(Simulation &simulation, const SimulationParameters &parameters, uint32_t ticks_run,
+                                       TaskControl *control, const std::function<void(uint32_t)> &on_tick)
+{
+  RunSummary summary;
+  SimulationState state; // only the scalars ShouldStop looks at are filled, the vectors stay empty
+  uint32_t depleted_sensor_count = simulation.GetDepletedSensorCount();
+  float target_num = static_cast<float>(simulation.GetTargetNum());
+  while (true)
+  {
+    simulation.Tick();
+    ++ticks_run;
+    ++summary.ticks_run;
+    state.tick = simulation.GetTick();
+    state.covered_target_count = simulation.CountCoveredTargets();
+    state.all_target_covered = state.covered_target_count == simulation.GetTargetNum();
+    state.coverage_percentage = state.covered_target_count / target_num;
+    if (on_tick)
+    {
+      on_tick(state.covered_target_count);
+    }
+    if (summary.ticks_run == 1)
+    {
+      summary.initial_coverage = state.coverage_percentage;
+    }
+    if (summary.first_death_tick == RunSummary::kNoDeath && simulation.GetDepletedSensorCount() != depleted_sensor_count)
+    {
+      summary.first_death_tick = state.tick;
+    }
+    summary.coverage_integral += state.coverage_percentage;
+    summary.min_coverage = std::min(summary.min_coverage, state.coverage_percentage);
+    summary.lifetime = state.tick;
+    summary.final_coverage = state.coverage_percentage;
+    if (ShouldStop(parameters, state) || ticks_run >= parameters.max_ticks)
+    {
+      summary.finished = true;
+      return summary;
+    }
+    if (control && control->IsCancelled())
+    {
+      return summary;
+    }
+  }
+}
+
+void SimulationManager::ValidatePositions(std::span<const Point> positions, const std::string &name)
+{
+  // counting instead of returning early keeps the loop branch-free, so the compiler can vectorize it
+  constexpr double kMax = std::numeric_limits<double>::max();
+  size_t invalid = 0;
+  for (const Point &p : positions)
+  {
+    invalid += !(std::abs(p.x) <= kMax) | !(std::abs(p.y) <= kMax);
+  }
+  if (invalid > 0)
+  {
+    throw std::runtime_error(name + " positions must be finite, found " + std::to_string(invalid) + " invalid");
+  }
+}
+
+void SimulationManager::ValidateScenario(ScenarioView scenario)
+{
+  if (scenario.target_positions.empty())
+  {
+    throw std::runtime_error("Scenario must contain at least one target");
+  }
+  if (scenario.sensor_positions.empty())
+  {
+    throw std::runtime_error("Scenario must contain at least one sensor");
+  }
+  ValidatePositions(scenario.target_positions, "Target");
+  ValidatePositions(scenario.sensor_positions, "Sensor");
+}
+
+ScenarioView SimulationManager::GetScenarioView() const
+{
+  if (scenario_file_)
+  {
+    return scenario_file_->GetPositions();
+  }
+  if (!scenario_.has_value())
+  {
+    throw std::runtime_error("Scenario not set");
+  }
+  return *scenario_;
+}
+
+void SimulationManager::EnsureIdle() const
+{
+  if (task_ && !task_->IsDone())
+  {
+    throw std::runtime_error("Simulation task still running");
+  }
+}
+
+void SimulationManager::CheckInitializable() const
 {
   if (!parameters_.has_value())
   {
     throw std::runtime_error("Parameters not set");
   }
-  if (!scenario_.has_value())
+  if (!HasScenario())
   {
     throw std::runtime_error("Scenario not set");
   }
@@ -135,69 +512,79 @@ void SimulationManager::Initialize()
   {
     throw std::runtime_error("Simulation already initialized");
   }
-  simulation_ = Simulation();
-  simulation_->Initialize(*parameters_, *scenario_);
-  is_initialized_ = true;
 }
 
-void SimulationManager::Run()
+void SimulationManager::CheckRunnable() const
 {
   if (!simulation_.has_value())
   {
     throw std::runtime_error("Simulation not initialized");
   }
-  auto max_ticks = parameters_->max_ticks;
-  for (uint32_t i = 0; i < max_ticks; ++i)
+  if (is_finished_)
   {
-    simulation_->Tick();
-    SimulationState state = simulation_->GetSimulationState();
-    states_.emplace_back(state);
-    if (ShouldStop(state))
-    {
-      break;
-    }
+    throw std::runtime_error("Simulation already finished");
   }
 }
 
-void SimulationManager::Reset()
+void SimulationManager::InitializeSimulation(TaskControl *control)
 {
-  parameters_.reset();
-  scenario_.reset();
-  simulation_.reset();
-  states_.clear();
-  is_initialized_ = false;
+  simulation_ = Simulation();
+  layout_hash_.reset();
+  try
+  {
+    simulation_->Initialize(*parameters_, GetScenarioView(), spatial_ordering_, control);
+  }
+  catch (...)
+  {
+    simulation_.reset(); // a failed or cancelled initialization can be retried
+    throw;
+  }
+  is_initialized_ = true;
 }
 
-json SimulationManager::LoadJSON(const std::string &json_path)
+void SimulationManager::Advance(uint32_t tick_num, const std::function<bool(const SimulationState &)> &predicate, SimulationState *last, TaskControl *control)
 {
-  std::ifstream file(json_path);
-  if (!file.is_open())
+  CheckRunnable();
+  for (uint32_t i = 0; i < tick_num && !is_finished_; ++i)
   {
-    throw std::runtime_error("Failed to open JSON file: " + json_path);
+    simulation_->Tick();
+    ++ticks_run_;
+    SimulationState &state = state_buffer_;
+    simulation_->FillSimulationState(state);
+    is_finished_ = ShouldStop(*parameters_, state) || ticks_run_ >= parameters_->max_ticks;
+    bool done = is_finished_ || i + 1 == tick_num || (predicate && predicate(state));
+    if (done && last)
+    {
+      *last = state; // copy only the state handed back to the caller
+    }
+    Emit(std::move(state)); // the next tick refills whatever buffers the sink left behind
+    if (control)
+    {
+      control->SetProgress(static_cast<float>(ticks_run_) / parameters_->max_ticks);
+    }
+    if (done || (control && control->IsCancelled()))
+    {
+      break;
+    }
+  }
+  if (control && is_finished_)
+  {
+    control->SetProgress(1.0f);
+  }
+  if (sink_)
+  {
+    sink_->Flush();
   }
-  json j;
-  file >> j;
-  return j;
 }
 
-bool SimulationManager::ShouldStop(const SimulationState &state) const
+void SimulationManager::Emit(SimulationState &&state)
 {
-  switch (parameters_->stop_condition)
+  if (sink_)
   {
-  case SimulationStopCondition::kManual:
-    return false;
-    break;
-  case SimulationStopCondition::kZeroCoverage:
-    return state.covered_target_count == 0;
-    break;
-  case SimulationStopCondition::kCoverageBelowThreshold:
-    return state.coverage_percentage < parameters_->stop_threshold;
-    break;
-  case SimulationStopCondition::kAnyCoverageLost:
-    return !state.all_target_covered;
-    break;
-  default:
-    return false;
-    break;
+    sink_->Push(std::move(state));
   }
-}
\ No newline at end of file
+  else
+  {
+    history_.Push(std::move(state));
+  }
+}
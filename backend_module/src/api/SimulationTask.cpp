@@ -0,0 +1,47 @@
+#include "api/SimulationTask.hpp"
+
+SimulationTask::SimulationTask(std::function<void(TaskControl &)> work)
+{
+  // the thread is started last, once every member it touches is constructed
+  worker_ = std::thread([this, work = std::move(work)]()
+                        {
+                          std::exception_ptr error;
+                          try
+                          {
+                            work(control_);
+                          }
+                          catch (...)
+                          {
+                            error = std::current_exception();
+                          }
+                          std::lock_guard lock(mutex_);
+                          error_ = error;
+                          is_done_ = true;
+                          done_.notify_all(); });
+}
+
+SimulationTask::~SimulationTask()
+{
+  Cancel();
+  if (worker_.joinable())
+  {
+    worker_.join();
+  }
+}
+
+bool SimulationTask::IsDone() const
+{
+  std::lock_guard lock(mutex_);
+  return is_done_;
+}
+
+void SimulationTask::Wait() const
+{
+  std::unique_lock lock(mutex_);
+  done_.wait(lock, [this]()
+             { return is_done_; });
+  if (error_)
+  {
+    std::rethrow_exception(error_);
+  }
+}
@@ -0,0 +1,79 @@
+#include "api/StateSink.hpp"
+
+RingBufferStateSink::RingBufferStateSink(size_t capacity) : capacity_(capacity)
+{
+  if (capacity_ == 0)
+  {
+    throw std::runtime_error("Ring buffer capacity must be greater than 0");
+  }
+  buffer_.reserve(capacity_);
+}
+
+void RingBufferStateSink::Push(SimulationState &&state)
+{
+  if (buffer_.size() < capacity_)
+  {
+    buffer_.emplace_back(std::move(state));
+    return;
+  }
+  std::swap(buffer_[next_], state); // the dropped state goes back to the producer for reuse
+  next_ = (next_ + 1) % capacity_;
+}
+
+std::vector<SimulationState> RingBufferStateSink::GetStates() const
+{
+  std::vector<SimulationState> states;
+  states.reserve(buffer_.size());
+  for (size_t i = 0; i < buffer_.size(); ++i)
+  {
+    states.emplace_back(buffer_[(next_ + i) % buffer_.size()]);
+  }
+  return states;
+}
+
+FileStateSink::FileStateSink(const std::string &path) : file_(path)
+{
+  if (!file_.is_open())
+  {
+    throw std::runtime_error("Failed to open file for writing: " + path);
+  }
+}
+
+void FileStateSink::Push(SimulationState &&state)
+{
+  line_.clear();
+  JsonStateWriter::AppendState(line_, state);
+  line_ += '\n';
+  file_.write(line_.data(), line_.size());
+}
+
+JsonStateSink::JsonStateSink(const std::string &path, int indent) : file_(path, std::ios::binary), writer_(file_, indent)
+{
+  if (!file_.is_open())
+  {
+    throw std::runtime_error("Failed to open file for writing: " + path);
+  }
+}
+
+JsonStateSink::~JsonStateSink()
+{
+  try
+  {
+    Flush();
+  }
+  catch (...)
+  {
+    // destructors must not throw, call Flush explicitly to observe errors
+  }
+}
+
+void JsonStateSink::Flush()
+{
+  std::streamoff closing_size = writer_.Close();
+  file_.flush();
+  if (!file_)
+  {
+    throw std::runtime_error("Failed to write JSON states");
+  }
+  file_.seekp(-closing_size, std::ios::cur); // the next state replaces the closing bracket
+}
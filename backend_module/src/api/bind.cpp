@@ -1,7 +1,15 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include "api/SimulationManager.hpp"
+#include "api/StateSink.hpp"
+#include "api/SimulationTask.hpp"
+#include "api/HistoryArrays.hpp"
+#include "api/BinaryHistory.hpp"
+#include "api/BatchRunner.hpp"
+#include "api/ParameterSweep.hpp"
 #include "core/Simulation.hpp"
 #include "core/Sensor.hpp"
 /**
@@ -17,8 +25,43 @@ PYBIND11_MAKE_OPAQUE(std::vector<int32_t>);
 PYBIND11_MAKE_OPAQUE(std::vector<Sensor::State>);
 PYBIND11_MAKE_OPAQUE(std::vector<SimulationState>);
 
+/**
+ * @brief Exposes a vector as a read-only NumPy array without copying.
+ * @param data The vector holding the elements.
+ * @param shape The shape of the array. The product of its dimensions must equal the size of data.
+ * @param owner Python object owning data. The array keeps it alive.
+ * @param dtype The element type seen by NumPy, by default the type of the elements.
+ * @return The array viewing data.
+ */
+template <typename T>
+py::array MakeArrayView(const std::vector<T> &data, std::vector<py::ssize_t> shape, py::handle owner, py::dtype dtype = py::dtype::of<T>())
+{
+  py::array array(dtype, std::move(shape), {}, data.data(), owner);
+  array.attr("setflags")(py::arg("write") = false);
+  return array;
+}
+
+/**
+ * @brief Gets the number of points stored in an (N, 2) array.
+ * @param array The array of coordinates, one point per row.
+ * @param name The name of the array used in the error message.
+ * @return The number of rows.
+ * @throws std::runtime_error if the array does not have shape (N, 2).
+ */
+static size_t PointCount(const py::array_t<double, py::array::c_style | py::array::forcecast> &array, const std::string &name)
+{
+  if (array.ndim() != 2 || array.shape(1) != 2)
+  {
+    throw std::runtime_error(name + " positions must be an array of shape (N, 2)");
+  }
+  return static_cast<size_t>(array.shape(0));
+}
+
 PYBIND11_MODULE(backend_module, m)
 {
+    // opaque, so it needs a registered type; lists convert to it implicitly
+    py::bind_vector<std::vector<uint32_t>>(m, "VectorUInt32");
+
     py::class_<Point>(m, "Point")
         .def(py::init<>())
         .def(py::init<double, double>())
@@ -43,7 +86,10 @@ PYBIND11_MODULE(backend_module, m)
              py::arg("max_ticks"))
         .def_readwrite("sensor_radious", &SimulationParameters::sensor_radius)
         .def_readwrite("initial_battery_lvl", &SimulationParameters::initial_battery_lvl)
-        .def_readwrite("reshuffle_interval", &SimulationParameters::reshuffle_interval);
+        .def_readwrite("reshuffle_interval", &SimulationParameters::reshuffle_interval)
+        .def_readwrite("max_ticks", &SimulationParameters::max_ticks)
+        .def_readwrite("stop_condition", &SimulationParameters::stop_condition)
+        .def_readwrite("stop_threshold", &SimulationParameters::stop_threshold);
 
     py::class_<SimulationScenario>(m, "SimulationScenario")
         .def(py::init<>())
@@ -62,24 +108,238 @@ PYBIND11_MODULE(backend_module, m)
         .def_readwrite("sensor_states", &SimulationState::sensor_states)
         .def_readwrite("sensor_battery_lvls", &SimulationState::sensor_battery_lvls);
 
+    py::class_<RunSummary>(m, "RunSummary")
+        .def_readonly_static("kNoDeath", &RunSummary::kNoDeath)
+        .def_readonly("lifetime", &RunSummary::lifetime)
+        .def_readonly("ticks_run", &RunSummary::ticks_run)
+        .def_readonly("first_death_tick", &RunSummary::first_death_tick)
+        .def_readonly("coverage_integral", &RunSummary::coverage_integral)
+        .def_readonly("min_coverage", &RunSummary::min_coverage)
+        .def_readonly("initial_coverage", &RunSummary::initial_coverage)
+        .def_readonly("final_coverage", &RunSummary::final_coverage)
+        .def_readonly("finished", &RunSummary::finished);
+
     py::enum_<SimulationStopCondition>(m, "SimulationStopCondition")
         .value("kManual", SimulationStopCondition::kManual)
         .value("kZeroCoverage", SimulationStopCondition::kZeroCoverage)
         .value("kCoverageBelowThreshold", SimulationStopCondition::kCoverageBelowThreshold)
         .value("kAnyCoverageLost", SimulationStopCondition::kAnyCoverageLost);
 
+    py::enum_<SpatialOrdering>(m, "SpatialOrdering")
+        .value("kInput", SpatialOrdering::kInput)
+        .value("kMorton", SpatialOrdering::kMorton)
+        .value("kHilbert", SpatialOrdering::kHilbert);
+
+    py::enum_<ScenarioLayout>(m, "ScenarioLayout")
+        .value("kUniform", ScenarioLayout::kUniform)
+        .value("kRadial", ScenarioLayout::kRadial)
+        .value("kGaussianMixture", ScenarioLayout::kGaussianMixture)
+        .value("kJitteredGrid", ScenarioLayout::kJitteredGrid)
+        .value("kPoissonDisk", ScenarioLayout::kPoissonDisk);
+
+    py::class_<ScenarioGeneratorOptions>(m, "ScenarioGeneratorOptions")
+        .def(py::init<>())
+        .def_readwrite("layout", &ScenarioGeneratorOptions::layout)
+        .def_readwrite("seed", &ScenarioGeneratorOptions::seed)
+        .def_readwrite("cluster_num", &ScenarioGeneratorOptions::cluster_num)
+        .def_readwrite("cluster_spread", &ScenarioGeneratorOptions::cluster_spread)
+        .def_readwrite("jitter", &ScenarioGeneratorOptions::jitter)
+        .def_readwrite("min_distance", &ScenarioGeneratorOptions::min_distance)
+        .def_readwrite("neighborhood_radius", &ScenarioGeneratorOptions::neighborhood_radius);
+
+    m.def("GenerateScenario", &GenerateScenario,
+          py::arg("target_num"), py::arg("sensor_num"), py::arg("options") = ScenarioGeneratorOptions(),
+          py::call_guard<py::gil_scoped_release>());
+
+    py::class_<BatchSpec>(m, "BatchSpec")
+        .def(py::init<>())
+        .def_readwrite("parameters", &BatchSpec::parameters)
+        .def_readwrite("target_num", &BatchSpec::target_num)
+        .def_readwrite("sensor_num", &BatchSpec::sensor_num)
+        .def_readwrite("generator", &BatchSpec::generator)
+        .def_readwrite("ordering", &BatchSpec::ordering)
+        .def_readwrite("run_num", &BatchSpec::run_num)
+        .def_readwrite("percentiles", &BatchSpec::percentiles)
+        .def_readwrite("thread_num", &BatchSpec::thread_num);
+
+    py::class_<BatchRunSummary>(m, "BatchRunSummary")
+        .def_readonly("run", &BatchRunSummary::run)
+        .def_readonly("seed", &BatchRunSummary::seed)
+        .def_readonly("failed", &BatchRunSummary::failed)
+        .def_readonly("error", &BatchRunSummary::error)
+        .def_readonly("lifetime", &BatchRunSummary::lifetime)
+        .def_readonly("initial_coverage", &BatchRunSummary::initial_coverage)
+        .def_readonly("final_coverage", &BatchRunSummary::final_coverage);
+
+    py::class_<BatchStatistics>(m, "BatchStatistics")
+        .def_readonly("run_num", &BatchStatistics::run_num)
+        .def_readonly("failed_run_num", &BatchStatistics::failed_run_num)
+        .def_readonly("lifetime_mean", &BatchStatistics::lifetime_mean)
+        .def_readonly("lifetime_stddev", &BatchStatistics::lifetime_stddev)
+        .def_readonly("lifetime_min", &BatchStatistics::lifetime_min)
+        .def_readonly("lifetime_max", &BatchStatistics::lifetime_max)
+        .def_readonly("lifetime_percentiles", &BatchStatistics::lifetime_percentiles)
+        .def_readonly("coverage_mean", &BatchStatistics::coverage_mean)
+        .def_readonly("coverage_percentiles", &BatchStatistics::coverage_percentiles);
+
+    // on_run is called from worker threads and reacquires the GIL for each summary
+    py::class_<BatchRunner>(m, "BatchRunner")
+        .def(py::init<BatchSpec>(), py::arg("spec"))
+        .def("GetSpec", &BatchRunner::GetSpec, py::return_value_policy::reference_internal)
+        .def("Run", [](const BatchRunner &runner, const std::function<void(const BatchRunSummary &)> &on_run)
+             { return runner.Run(on_run); },
+             py::arg("on_run") = py::none(), py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SweepGrid>(m, "SweepGrid")
+        .def(py::init<>())
+        .def_readwrite("sensor_radii", &SweepGrid::sensor_radii)
+        .def_readwrite("initial_battery_lvls", &SweepGrid::initial_battery_lvls)
+        .def_readwrite("reshuffle_intervals", &SweepGrid::reshuffle_intervals)
+        .def_readwrite("max_ticks", &SweepGrid::max_ticks)
+        .def_readwrite("stop_conditions", &SweepGrid::stop_conditions)
+        .def_readwrite("stop_thresholds", &SweepGrid::stop_thresholds);
+
+    m.def("ExpandSweepGrid", &ExpandSweepGrid, py::arg("grid"));
+
+    py::class_<SweepResult>(m, "SweepResult")
+        .def_readonly("variant", &SweepResult::variant)
+        .def_readonly("parameters", &SweepResult::parameters)
+        .def_readonly("failed", &SweepResult::failed)
+        .def_readonly("error", &SweepResult::error)
+        .def_readonly("lifetime", &SweepResult::lifetime)
+        .def_readonly("initial_coverage", &SweepResult::initial_coverage)
+        .def_readonly("final_coverage", &SweepResult::final_coverage)
+        .def_readonly("min_coverage", &SweepResult::min_coverage)
+        .def_readonly("first_death_tick", &SweepResult::first_death_tick);
+
+    py::class_<ParameterSweep>(m, "ParameterSweep")
+        .def(py::init<SimulationScenario, std::vector<SimulationParameters>, SpatialOrdering, uint32_t>(),
+             py::arg("scenario"), py::arg("variants"), py::arg("ordering") = SpatialOrdering::kInput, py::arg("thread_num") = 0)
+        .def("GetVariants", &ParameterSweep::GetVariants, py::return_value_policy::reference_internal)
+        .def("Run", [](const ParameterSweep &sweep)
+             { return sweep.Run(); },
+             py::call_guard<py::gil_scoped_release>());
+
+    py::class_<StateSink, std::shared_ptr<StateSink>>(m, "StateSink")
+        .def("Flush", &StateSink::Flush);
+
+    py::class_<VectorStateSink, StateSink, std::shared_ptr<VectorStateSink>>(m, "VectorStateSink")
+        .def(py::init<>())
+        .def("GetStates", &VectorStateSink::GetStates, py::return_value_policy::reference_internal)
+        .def("Clear", &VectorStateSink::Clear);
+
+    py::class_<RingBufferStateSink, StateSink, std::shared_ptr<RingBufferStateSink>>(m, "RingBufferStateSink")
+        .def(py::init<size_t>(), py::arg("capacity"))
+        .def("GetCapacity", &RingBufferStateSink::GetCapacity)
+        .def("GetSize", &RingBufferStateSink::GetSize)
+        .def("GetStates", &RingBufferStateSink::GetStates);
+
+    py::class_<FileStateSink, StateSink, std::shared_ptr<FileStateSink>>(m, "FileStateSink")
+        .def(py::init<const std::string &>(), py::arg("path"));
+
+    py::class_<JsonStateSink, StateSink, std::shared_ptr<JsonStateSink>>(m, "JsonStateSink")
+        .def(py::init<const std::string &, int>(), py::arg("path"), py::arg("indent") = -1);
+
+    py::class_<BinaryStateSink, StateSink, std::shared_ptr<BinaryStateSink>>(m, "BinaryStateSink")
+        .def(py::init<const std::string &, uint32_t>(), py::arg("path"), py::arg("block_ticks") = 0);
+
+    py::class_<BinaryHistoryReader>(m, "BinaryHistoryReader")
+        .def(py::init<const std::string &>(), py::arg("path"))
+        .def("GetTickCount", &BinaryHistoryReader::GetTickCount)
+        .def("GetSensorNum", &BinaryHistoryReader::GetSensorNum)
+        .def("GetTargetNum", &BinaryHistoryReader::GetTargetNum)
+        .def("GetTick", &BinaryHistoryReader::GetTick, py::arg("index"))
+        .def("GetState", &BinaryHistoryReader::GetState, py::arg("index"))
+        .def("GetStateAt", &BinaryHistoryReader::GetStateAt, py::arg("tick"))
+        .def("__len__", &BinaryHistoryReader::GetTickCount);
+
+    py::class_<CallbackStateSink, StateSink, std::shared_ptr<CallbackStateSink>>(m, "CallbackStateSink")
+        .def(py::init<std::function<void(const SimulationState &)>>(), py::arg("callback"));
+
+    py::class_<HistoryArrays, std::shared_ptr<HistoryArrays>>(m, "HistoryArrays")
+        .def_property_readonly("tick_count", &HistoryArrays::GetTickCount)
+        .def_property_readonly("sensor_num", &HistoryArrays::GetSensorNum)
+        .def_property_readonly("target_num", &HistoryArrays::GetTargetNum)
+        .def_property_readonly("ticks", [](py::object self)
+                               {
+                                 const auto &arrays = self.cast<const HistoryArrays &>();
+                                 return MakeArrayView(arrays.GetTicks(), {(py::ssize_t)arrays.GetTickCount()}, self); })
+        .def_property_readonly("covered_target_counts", [](py::object self)
+                               {
+                                 const auto &arrays = self.cast<const HistoryArrays &>();
+                                 return MakeArrayView(arrays.GetCoveredTargetCounts(), {(py::ssize_t)arrays.GetTickCount()}, self); })
+        .def_property_readonly("coverage_percentages", [](py::object self)
+                               {
+                                 const auto &arrays = self.cast<const HistoryArrays &>();
+                                 return MakeArrayView(arrays.GetCoveragePercentages(), {(py::ssize_t)arrays.GetTickCount()}, self); })
+        .def_property_readonly("sensor_states", [](py::object self)
+                               {
+                                 const auto &arrays = self.cast<const HistoryArrays &>();
+                                 return MakeArrayView(arrays.GetSensorStates(), {(py::ssize_t)arrays.GetTickCount(), (py::ssize_t)arrays.GetSensorNum()}, self); })
+        .def_property_readonly("sensor_battery_lvls", [](py::object self)
+                               {
+                                 const auto &arrays = self.cast<const HistoryArrays &>();
+                                 return MakeArrayView(arrays.GetSensorBatteryLvls(), {(py::ssize_t)arrays.GetTickCount(), (py::ssize_t)arrays.GetSensorNum()}, self); })
+        .def_property_readonly("is_target_covered", [](py::object self)
+                               {
+                                 const auto &arrays = self.cast<const HistoryArrays &>();
+                                 return MakeArrayView(arrays.GetIsTargetCovered(), {(py::ssize_t)arrays.GetTickCount(), (py::ssize_t)arrays.GetTargetNum()}, self, py::dtype::of<bool>()); });
+
+    // method names follow concurrent.futures.Future, so the handle can be polled like one
+    py::class_<SimulationTask, std::shared_ptr<SimulationTask>>(m, "SimulationTask")
+        .def("done", &SimulationTask::IsDone)
+        .def("progress", &SimulationTask::GetProgress)
+        .def("cancel", &SimulationTask::Cancel)
+        .def("cancelled", &SimulationTask::IsCancelled)
+        .def("wait", &SimulationTask::Wait, py::call_guard<py::gil_scoped_release>());
+
+    // long running calls release the GIL; Python callbacks (sinks, predicates) reacquire it when invoked
     py::class_<SimulationManager>(m, "SimulationManager")
         .def(py::init<>())
-        .def("GetSimulationStates", &SimulationManager::GetSimulationStates, py::return_value_policy::reference)
+        .def("GetSimulationStates", &SimulationManager::GetSimulationStates)
+        .def("GetStateCount", &SimulationManager::GetStateCount)
+        .def("GetStateAt", &SimulationManager::GetStateAt, py::arg("tick"))
+        .def("GetHistoryArrays", &SimulationManager::GetHistoryArrays)
+        .def("DumpStatesToBinary", &SimulationManager::DumpStatesToBinary, py::arg("path"), py::call_guard<py::gil_scoped_release>())
         .def("GetParameters", &SimulationManager::GetParameters, py::return_value_policy::reference)
         .def("GetScenario", &SimulationManager::GetScenario, py::return_value_policy::reference)
         .def("IsInitialized", &SimulationManager::IsInitialized)
-        .def("LoadParametersFromJSON", &SimulationManager::LoadParametersFromJSON)
-        .def("LoadScenarioFromJSON", &SimulationManager::LoadScenarioFromJSON)
+        .def("IsFinished", &SimulationManager::IsFinished)
+        .def("GetTicksRun", &SimulationManager::GetTicksRun)
+        .def("LoadConfigFromJSON", &SimulationManager::LoadConfigFromJSON, py::call_guard<py::gil_scoped_release>())
+        .def("LoadParametersFromJSON", &SimulationManager::LoadParametersFromJSON, py::call_guard<py::gil_scoped_release>())
+        .def("LoadScenarioFromJSON", &SimulationManager::LoadScenarioFromJSON, py::call_guard<py::gil_scoped_release>())
+        .def("LoadGeneratedScenario", &SimulationManager::LoadGeneratedScenario,
+             py::arg("target_num"), py::arg("sensor_num"), py::arg("options") = ScenarioGeneratorOptions(),
+             py::call_guard<py::gil_scoped_release>())
+        .def("LoadScenarioFromCSV", &SimulationManager::LoadScenarioFromCSV, py::call_guard<py::gil_scoped_release>())
+        .def("LoadScenarioFromBinary", &SimulationManager::LoadScenarioFromBinary, py::call_guard<py::gil_scoped_release>())
+        .def("DumpScenarioToBinary", &SimulationManager::DumpScenarioToBinary, py::call_guard<py::gil_scoped_release>())
+        .def("SaveCheckpoint", &SimulationManager::SaveCheckpoint, py::arg("path"), py::call_guard<py::gil_scoped_release>())
+        .def("LoadCheckpoint", &SimulationManager::LoadCheckpoint, py::arg("path"), py::call_guard<py::gil_scoped_release>())
         .def("SetParameters", &SimulationManager::SetParameters)
-        .def("SetScenario", &SimulationManager::SetScenario)
-        .def("Initialize", &SimulationManager::Initialize)
-        .def("Run", &SimulationManager::Run)
+        .def("SetScenario", py::overload_cast<const SimulationScenario &>(&SimulationManager::SetScenario))
+        // arrays are read through their buffers, without creating a Point object per row
+        .def("SetScenario", [](SimulationManager &manager,
+                               const py::array_t<double, py::array::c_style | py::array::forcecast> &target_positions,
+                               const py::array_t<double, py::array::c_style | py::array::forcecast> &sensor_positions)
+             {
+               size_t target_num = PointCount(target_positions, "Target");
+               size_t sensor_num = PointCount(sensor_positions, "Sensor");
+               py::gil_scoped_release release;
+               manager.SetScenario(target_positions.data(), target_num, sensor_positions.data(), sensor_num); },
+             py::arg("target_positions"), py::arg("sensor_positions"))
+        .def("SetSpatialOrdering", &SimulationManager::SetSpatialOrdering)
+        .def("SetStateSink", &SimulationManager::SetStateSink, py::arg("sink").none(true))
+        .def("GetStateSink", &SimulationManager::GetStateSink)
+        .def("Initialize", &SimulationManager::Initialize, py::call_guard<py::gil_scoped_release>())
+        .def("Run", &SimulationManager::Run, py::call_guard<py::gil_scoped_release>())
+        .def("RunSummarized", &SimulationManager::RunSummarized, py::call_guard<py::gil_scoped_release>())
+        .def("Step", &SimulationManager::Step, py::call_guard<py::gil_scoped_release>())
+        .def("RunFor", &SimulationManager::RunFor, py::arg("tick_num"), py::call_guard<py::gil_scoped_release>())
+        .def("RunUntil", &SimulationManager::RunUntil, py::arg("predicate"), py::call_guard<py::gil_scoped_release>())
+        .def("InitializeAsync", &SimulationManager::InitializeAsync, py::keep_alive<0, 1>())
+        .def("RunAsync", &SimulationManager::RunAsync, py::keep_alive<0, 1>())
         .def("Reset", &SimulationManager::Reset);
 
     py::bind_vector<std::vector<bool>>(m, "VectorBool");
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "core/Simulation.hpp"
+/**
+ * @file benchmark.cpp
+ * @brief Measures throughput of the simulation on large random scenarios.
+ * @details Usage: cpp_benchmark [sensor_num] [target_num] [ticks]
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static SimulationScenario RandomScenario(uint32_t target_num, uint32_t sensor_num, uint32_t seed)
+{
+  SimulationScenario scenario;
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dist(0.0, 1.0);
+  scenario.target_positions.reserve(target_num);
+  scenario.sensor_positions.reserve(sensor_num);
+  for (uint32_t i = 0; i < target_num; ++i)
+  {
+    scenario.target_positions.emplace_back(dist(gen), dist(gen));
+  }
+  for (uint32_t i = 0; i < sensor_num; ++i)
+  {
+    scenario.sensor_positions.emplace_back(dist(gen), dist(gen));
+  }
+  return scenario;
+}
+
+static const char *OrderingName(SpatialOrdering ordering)
+{
+  switch (ordering)
+  {
+  case SpatialOrdering::kMorton:
+    return "morton";
+  case SpatialOrdering::kHilbert:
+    return "hilbert";
+  default:
+    return "input";
+  }
+}
+
+/**
+ * @brief Benchmarks reshuffle throughput for every spatial ordering.
+ * @details Reshuffle interval is set to 1, so every measured tick runs the full reshuffle protocol.
+ * The radius is chosen so that each sensor has about 5 sensors in range, which keeps neighborhoods below bit_vec_size.
+ */
+static void BenchmarkReshuffle(uint32_t sensor_num, uint32_t target_num, uint32_t ticks)
+{
+  const double radius = std::sqrt(5.0 / (3.14159265358979 * sensor_num));
+  SimulationParameters parameters(radius, ticks + 1, 1, SimulationStopCondition::kManual, 0.0f, ticks);
+  SimulationScenario scenario = RandomScenario(target_num, sensor_num, 42);
+  std::cout << "=== Reshuffle throughput: " << sensor_num << " sensors, " << target_num << " targets, R = " << radius << " ===\n";
+  for (SpatialOrdering ordering : {SpatialOrdering::kInput, SpatialOrdering::kMorton, SpatialOrdering::kHilbert})
+  {
+    Simulation simulation;
+    auto start = Clock::now();
+    simulation.Initialize(parameters, scenario, ordering);
+    double init_ms = ElapsedMs(start);
+    start = Clock::now();
+    for (uint32_t i = 0; i < ticks; ++i)
+    {
+      simulation.Tick();
+    }
+    double run_ms = ElapsedMs(start);
+    std::cout << "  " << OrderingName(ordering)
+              << ": init " << init_ms << " ms, "
+              << ticks << " reshuffles in " << run_ms << " ms ("
+              << ticks * 1000.0 / run_ms << " reshuffles/s)\n";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t sensor_num = argc > 1 ? std::stoul(argv[1]) : 100000;
+  uint32_t target_num = argc > 2 ? std::stoul(argv[2]) : sensor_num / 2;
+  uint32_t ticks = argc > 3 ? std::stoul(argv[3]) : 4;
+  BenchmarkReshuffle(sensor_num, target_num, ticks);
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include "core/CoverStorage.hpp"
+
+CoverStorage::CoverStorage(CsrGraph sensor_targets, CsrGraph sensor_sensors)
+    : sensor_targets_(std::move(sensor_targets)),
+      sensor_sensors_(std::move(sensor_sensors)),
+      cover_offsets_{0},
+      edge_offsets_{0}
+{
+  cover_offsets_.reserve(GetSensorNum() + 1);
+}
+
+CoverStorage::CoverStorage(CsrGraph sensor_targets, CsrGraph sensor_sensors, std::vector<uint32_t> cover_offsets, std::vector<Cover> initial_covers,
+                           std::vector<uint32_t> edge_offsets, std::vector<Edge> edges)
+    : sensor_targets_(std::move(sensor_targets)),
+      sensor_sensors_(std::move(sensor_sensors)),
+      cover_offsets_(std::move(cover_offsets)),
+      initial_covers_(std::move(initial_covers)),
+      edge_offsets_(std::move(edge_offsets)),
+      edges_(std::move(edges))
+{
+  auto is_csr = [](const std::vector<uint32_t> &offsets, size_t vertex_num, size_t edge_num)
+  {
+    return offsets.size() == vertex_num + 1 && offsets.front() == 0 && offsets.back() == edge_num &&
+           std::ranges::is_sorted(offsets);
+  };
+  size_t sensor_num = sensor_sensors_.offsets.size() - 1;
+  if (sensor_sensors_.offsets.empty() || !is_csr(sensor_sensors_.offsets, sensor_num, sensor_sensors_.indices.size()) ||
+      !is_csr(sensor_targets_.offsets, sensor_num, sensor_targets_.indices.size()) ||
+      !is_csr(cover_offsets_, sensor_num, initial_covers_.size()) ||
+      !is_csr(edge_offsets_, initial_covers_.size(), edges_.size()))
+  {
+    throw std::runtime_error("Cover storage arrays do not fit together");
+  }
+}
+
+void CoverStorage::AppendCovers(std::span<const LocalCovers> batches)
+{
+  size_t sensor_num = 0, cover_num = 0, edge_num = 0;
+  for (const LocalCovers &local : batches)
+  {
+    sensor_num += local.GetSensorNum();
+    cover_num += local.covers.size();
+    edge_num += local.edges.size();
+  }
+  cover_offsets_.reserve(cover_offsets_.size() + sensor_num);
+  initial_covers_.reserve(initial_covers_.size() + cover_num);
+  edge_offsets_.reserve(edge_offsets_.size() + cover_num);
+  edges_.reserve(edges_.size() + edge_num);
+  for (const LocalCovers &local : batches)
+  {
+    for (size_t s = 0; s < local.GetSensorNum(); ++s)
+    {
+      for (size_t k = local.cover_offsets[s]; k < local.cover_offsets[s + 1]; ++k)
+      {
+        Cover cover = local.covers[k];
+        cover.storage_idx = initial_covers_.size();
+        initial_covers_.emplace_back(cover);
+        edges_.insert(edges_.end(), local.edges.begin() + local.edge_offsets[k], local.edges.begin() + local.edge_offsets[k + 1]);
+        edge_offsets_.emplace_back(edges_.size());
+      }
+      cover_offsets_.emplace_back(initial_covers_.size());
+    }
+  }
+}
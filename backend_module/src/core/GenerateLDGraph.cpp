@@ -1,62 +1,49 @@
 #include "core/GenerateLDGraph.hpp"
 
 LDGraphGenerator::LDGraphGenerator(
-    std::vector<Sensor *> &sensors,
-    std::vector<Target *> &targets)
+    std::span<const uint32_t> sensors,
+    std::span<const Sensor> all_sensors,
+    size_t target_num,
+    std::span<const bit_vec> sensor_cover_masks,
+    std::pmr::memory_resource *scratch)
     : sensors_(sensors),
-      targets_(targets),
-      sensor_num_(sensors.size()),
-      target_num_(targets.size()),
-      sensor_cover_masks_(),
-      cover_masks_(),
-      covers_(),
-      graph_(), 
+      all_sensors_(all_sensors),
+      sensor_num_(sensors_.size()),
+      target_num_(target_num),
+      sensor_cover_masks_(sensor_cover_masks),
+      scratch_(scratch),
       full_cover((1 << target_num_) - 1),
       full_sensor((1 << sensor_num_) - 1)
 {
 }
 
-std::pair<std::vector<Cover>, LDGraph> LDGraphGenerator::operator()()
+void LDGraphGenerator::operator()(LocalCovers &out)
 {
-  GenerateSensorCoverMasks();
-  GenerateMinimalCoverMasks();
-  InitializeCoverData();
-  GenerateLDGraph();
-  GenerateCoverData();
-  return std::pair(covers_, graph_);
-}
-
-std::vector<Sensor *> LDGraphGenerator::MaskToSensors(bit_vec mask)
-{
-  std::vector<Sensor *> result;
-  bit_vec rem = mask;
-  while (rem)
+  std::pmr::vector<bit_vec> cover_masks(scratch_);
+  GenerateMinimalCoverMasks(cover_masks);
+  size_t first = out.covers.size();
+  for (bit_vec mask : cover_masks)
   {
-    int i = std::countr_zero(rem);
-    rem &= (rem - 1);
-    result.push_back(sensors_[i]);
+    out.covers.emplace_back(0, mask, true, 0, 0, 0, 0);
   }
-  return result;
+  GenerateLDGraph(cover_masks, out);
+  GenerateCoverData(std::span<Cover>(out.covers.begin() + first, out.covers.end()), out);
+  out.cover_offsets.emplace_back(out.covers.size());
 }
 
-void LDGraphGenerator::GenerateSensorCoverMasks()
+uint16_t LDGraphGenerator::MinBatteryLevel(bit_vec mask) const
 {
-  int i = 0;
-  for (auto *sensor : sensors_)
+  uint16_t result = std::numeric_limits<uint16_t>::max();
+  for (bit_vec rem = mask; rem; rem &= rem - 1)
   {
-    bit_vec mask = 0;
-    for (auto *target : targets_)
-    {
-      mask <<= 1;
-      mask |= sensor->IsLocalTarget(*target);
-    }
-    sensor_cover_masks_.emplace_back(mask);
+    result = std::min(result, all_sensors_[sensors_[std::countr_zero(rem)]].GetBatteryLevel());
   }
+  return result;
 }
 
-void LDGraphGenerator::GenerateMinimalCoverMasks()
+void LDGraphGenerator::GenerateMinimalCoverMasks(std::pmr::vector<bit_vec> &cover_masks)
 {
-  std::unordered_map<bit_vec, bool> lookup_table;
+  std::pmr::unordered_map<bit_vec, bool> lookup_table(scratch_);
 
   auto is_cover = [&](bit_vec candidate) -> bool
   {
@@ -73,9 +60,9 @@ void LDGraphGenerator::GenerateMinimalCoverMasks()
 
   auto minimal_covers_aux = [&](auto self, bit_vec candidate) -> bool
   {
-    if (lookup_table.contains(candidate))
+    if (auto it = lookup_table.find(candidate); it != lookup_table.end())
     {
-      return lookup_table[candidate];
+      return it->second;
     }
     if (!is_cover(candidate))
     {
@@ -97,65 +84,74 @@ void LDGraphGenerator::GenerateMinimalCoverMasks()
     {
       return lookup_table[candidate] = true;
     }
-    cover_masks_.emplace_back(candidate);
+    cover_masks.emplace_back(candidate);
     return lookup_table[candidate] = true;
   };
   minimal_covers_aux(minimal_covers_aux, full_sensor);
 }
 
-void LDGraphGenerator::InitializeCoverData()
+void LDGraphGenerator::GenerateLDGraph(std::span<const bit_vec> cover_masks, LocalCovers &out)
 {
-  for (bit_vec mask : cover_masks_)
+  size_t cover_num = cover_masks.size();
+  // cursor[i] is where the next edge of cover i goes, relative to the first edge of the sensor
+  std::pmr::vector<uint32_t> cursor(cover_num + 1, 0, scratch_);
+  for (size_t i = 0; i < cover_num; ++i)
+  {
+    for (size_t j = i + 1; j < cover_num; ++j)
+    {
+      if (cover_masks[i] & cover_masks[j])
+      {
+        ++cursor[i + 1];
+        ++cursor[j + 1];
+      }
+    }
+  }
+  for (size_t i = 0; i < cover_num; ++i)
   {
-    auto sensors_in_cover = MaskToSensors(mask);
-    covers_.emplace_back(sensors_in_cover, 0, 0, 0, 0);
+    cursor[i + 1] += cursor[i];
   }
-}
-
-void LDGraphGenerator::GenerateLDGraph()
-{
-  graph_ = LDGraph(covers_.size(), Adjacent());
-
-  for (size_t i = 0; i < covers_.size(); ++i)
+  size_t edge_base = out.edges.size();
+  out.edges.resize(edge_base + cursor[cover_num]);
+  for (size_t i = 0; i < cover_num; ++i)
   {
-    for (size_t j = i + 1; j < covers_.size(); ++j)
+    out.edge_offsets.emplace_back(edge_base + cursor[i + 1]);
+  }
+  // edges of a cover come out sorted by the other cover, the order the per-cover lists used to have
+  for (size_t i = 0; i < cover_num; ++i)
+  {
+    for (size_t j = i + 1; j < cover_num; ++j)
     {
-      bit_vec intersection_mask = cover_masks_[i] & cover_masks_[j];
+      bit_vec intersection_mask = cover_masks[i] & cover_masks[j];
       if (intersection_mask == 0)
       {
         continue;
       }
-      uint16_t weight = std::numeric_limits<uint16_t>::max();
-      const std::vector<Sensor *> intersection = MaskToSensors(intersection_mask);
-      for (const Sensor *sensor : intersection)
-      {
-        weight = std::min(weight, sensor->GetBatteryLevel());
-      }
-      graph_[i].emplace_back(j, weight);
-      graph_[j].emplace_back(i, weight);
+      uint16_t weight = MinBatteryLevel(intersection_mask);
+      out.edges[edge_base + cursor[i]++] = Edge(j, weight);
+      out.edges[edge_base + cursor[j]++] = Edge(i, weight);
     }
   }
 }
 
-void LDGraphGenerator::GenerateCoverData()
+void LDGraphGenerator::GenerateCoverData(std::span<Cover> covers, const LocalCovers &out)
 {
-  for (size_t i = 0; i < covers_.size(); ++i)
+  size_t first = out.covers.size() - covers.size();
+  for (size_t i = 0; i < covers.size(); ++i)
   {
-    Adjacent &adj = graph_[i];
-    Cover &cover = covers_[i];
-    cover.degree = 0;
-    for (const auto &[_, weight] : adj)
+    Cover &cover = covers[i];
+    uint16_t degree = 0;
+    for (size_t e = out.edge_offsets[first + i]; e < out.edge_offsets[first + i + 1]; ++e)
     {
-      cover.degree += weight;
+      degree += out.edges[e].second;
     }
-    cover.lifetime = std::numeric_limits<uint16_t>::max();
-    cover.remaining_to_on = cover.sensors.size();
-    cover.min_id = std::numeric_limits<uint32_t>::max();
-    cover.feasible = false;
-    for (const Sensor *sensor : cover.sensors)
+    uint16_t lifetime = std::numeric_limits<uint16_t>::max();
+    uint32_t min_id = std::numeric_limits<uint32_t>::max();
+    for (bit_vec rem = cover.members; rem; rem &= rem - 1)
     {
-      cover.lifetime = std::min(cover.lifetime, sensor->GetBatteryLevel());
-      cover.min_id = std::min(cover.min_id, sensor->GetId());
+      const Sensor &sensor = all_sensors_[sensors_[std::countr_zero(rem)]];
+      lifetime = std::min(lifetime, sensor.GetBatteryLevel());
+      min_id = std::min<uint32_t>(min_id, sensor.GetId());
     }
+    cover = Cover(0, cover.members, false, degree, lifetime, std::popcount(cover.members), min_id);
   }
-}
\ No newline at end of file
+}
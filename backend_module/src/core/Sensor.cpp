@@ -53,13 +53,16 @@
 //   }
 // }
 
-void Sensor::Initialize()
+void Sensor::Initialize(uint32_t idx, const NetworkView &network, std::span<const bit_vec> sensor_cover_masks, LocalCovers &out, std::pmr::memory_resource *scratch)
 {
-  auto target_num = local_targets_.size();
-  auto sensor_num = local_sensors_.size();
+  std::span<const uint32_t> local_targets = network.storage->LocalTargets(idx);
+  std::span<const uint32_t> local_sensors = network.storage->LocalSensors(idx);
+  auto target_num = local_targets.size();
+  auto sensor_num = local_sensors.size();
   if (target_num == 0)
   {
     state_ = State::kDead;
+    out.cover_offsets.emplace_back(out.covers.size());
     return;
   }
   if (bit_vec_size < target_num)
@@ -72,33 +75,19 @@ void Sensor::Initialize()
     std::string msg = std::format("more than {} sensors for: {} ({},{})", bit_vec_size, this->GetId(), position_.x, position_.y);
     throw std::runtime_error(msg);
   }
-  std::vector<Sensor *> all_sensors = local_sensors_;
-  all_sensors.emplace_back(this);
-  std::vector<Target *> all_targets;
-  std::unordered_set<Target *> unique_targets;
-  for (auto *t : local_targets_)
-  {
-    unique_targets.insert(t);
-  }
-  // for (auto *s : local_sensors_) //optional. doesnt work to well
-  // {
-  //   for (auto *t : s->GetLocalTargets())
-  //   {
-  //     unique_targets.insert(t);
-  //   }
-  // }
-  all_targets.assign(unique_targets.begin(), unique_targets.end());
-  std::tie(covers_, local_graph_) = LDGraphGenerator{all_sensors, all_targets}();
+  std::pmr::vector<uint32_t> all_sensors(local_sensors.begin(), local_sensors.end(), scratch);
+  all_sensors.emplace_back(idx);
+  LDGraphGenerator{all_sensors, network.sensors, target_num, sensor_cover_masks, scratch}(out);
 
   // debug_prints
   // std::cout << "=== Sensor Id: " << GetId() << " ===";
   // std::cout << "\nT: ";
-  // for (auto *i : all_targets)
+  // for (auto i : local_targets)
   // {
   //   std::cout << i->GetId() << ", ";
   // }
   // std::cout << "\nS: ";
-  // for (auto *i : all_sensors)
+  // for (auto i : all_sensors)
   // {
   //   std::cout << i->GetId() << ", ";
   // }
@@ -107,35 +96,70 @@ void Sensor::Initialize()
   // PrintLDGraph(local_graph_);
 }
 
-void Sensor::Update()
+void Sensor::ResetRuntime(uint32_t battery_lvl, bool has_targets, uint32_t cover_num)
+{
+  battery_lvl_ = battery_lvl;
+  state_ = has_targets ? State::kUndecided : State::kDead;
+  current_cover_idx_ = 0;
+  live_cover_num_ = cover_num;
+  dead_members_ = 0;
+}
+
+bool Sensor::RestorePruning(uint32_t idx, const NetworkView &network)
+{
+  const CoverStorage &storage = *network.storage;
+  std::span<const Cover> covers = network.covers.subspan(storage.CoverBegin(idx), storage.CoverEnd(idx) - storage.CoverBegin(idx));
+  dead_members_ = 0;
+  live_cover_num_ = 0;
+  if (state_ == State::kDead)
+  {
+    return true;
+  }
+  std::span<const uint32_t> local_sensors = storage.LocalSensors(idx);
+  for (size_t k = 0; k < local_sensors.size(); ++k)
+  {
+    if (network.sensors[local_sensors[k]].GetState() == State::kDead)
+    {
+      dead_members_ |= bit_vec{1} << k;
+    }
+  }
+  auto live_end = std::ranges::find_if(covers, [&](const Cover &cover) { return cover.members & dead_members_; });
+  live_cover_num_ = live_end - covers.begin();
+  return std::none_of(live_end, covers.end(), [&](const Cover &cover) { return !(cover.members & dead_members_); });
+}
+
+bool Sensor::Update(uint32_t idx, const NetworkView &network)
 {
   if (state_ != State::kOn)
   {
-    return;
+    return false;
   }
   --battery_lvl_;
-  for (auto &target : local_targets_)
+  for (uint32_t target : network.storage->LocalTargets(idx))
   {
-    target->SetCoverFlag(true);
+    network.targets[target].SetCoverFlag(true);
   }
   if (battery_lvl_ == 0)
   {
     state_ = State::kDead;
+    return true;
   }
+  return false;
 }
 
-void Sensor::UpdateCoverData()
+void Sensor::UpdateCoverData(uint32_t idx, std::span<Cover> covers, const NetworkView &network)
 {
   bool does_changed = false;
-  for (Cover &cover : covers_)
+  for (Cover &cover : covers)
   {
     auto lifetime = std::numeric_limits<uint16_t>::max();
-    auto remaining_to_on = cover.sensors.size();
+    uint16_t remaining_to_on = std::popcount(cover.members);
     auto feasible = true;
-    for (Sensor *sensor : cover.sensors)
+    for (bit_vec rem = cover.members; rem; rem &= rem - 1)
     {
-      lifetime = std::min(lifetime, sensor->battery_lvl_);
-      switch (sensor->GetState())
+      const Sensor &sensor = network.sensors[network.storage->MemberAt(idx, std::countr_zero(rem))];
+      lifetime = std::min(lifetime, sensor.battery_lvl_);
+      switch (sensor.GetState())
       {
       case State::kOn:
         --remaining_to_on;
@@ -147,18 +171,18 @@ void Sensor::UpdateCoverData()
         break;
       }
     }
-    if (lifetime != cover.lifetime || remaining_to_on != cover.remaining_to_on || feasible != cover.feasible)
+    Cover updated = cover;
+    updated.SetRuntime(feasible, lifetime, remaining_to_on);
+    if (updated.key != cover.key)
     {
       does_changed = true;
       current_cover_idx_ = 0; // important
-      cover.lifetime = lifetime;
-      cover.remaining_to_on = remaining_to_on;
-      cover.feasible = feasible;
+      cover = updated;
     }
   }
   if (does_changed)
   {
-    std::sort(covers_.begin(), covers_.end());
+    std::sort(covers.begin(), covers.end());
   }
 }
 
@@ -172,29 +196,39 @@ void Sensor::BeginReshuffle()
   current_cover_idx_ = 0;
 }
 
-bool Sensor::Reshuffle()
+bool Sensor::Reshuffle(uint32_t idx, const NetworkView &network)
 {
   if (state_ != State::kUndecided)
   {
     return true;
   }
-  UpdateCoverData();
-  current_cover_ = &covers_[current_cover_idx_ % covers_.size()];
-  if (GetId() == current_cover_->min_id && current_cover_->Contains(this))
+  std::span<Cover> covers = network.CoversOf(idx);
+  if (covers.empty()) // every cover lost a member, nothing to agree on
+  {
+    state_ = State::kOn;
+    return true;
+  }
+  UpdateCoverData(idx, covers, network);
+  const Cover &current_cover = covers[current_cover_idx_ % covers.size()];
+  const CoverStorage &storage = *network.storage;
+  bool contains_self = current_cover.members & storage.SelfBit(idx);
+  if (GetId() == current_cover.GetMinId() && contains_self)
   {
     state_ = State::kOn;
     return true;
   }
   bool next_index = false;
   bool satisfied = true;
-  for (auto *s : local_sensors_)
+  std::span<const uint32_t> local_sensors = storage.LocalSensors(idx);
+  for (size_t k = 0; k < local_sensors.size(); ++k)
   {
-    if (s == this)
+    uint32_t s = local_sensors[k];
+    if (s == idx)
     {
       continue;
     }
-    bool contains = current_cover_->Contains(s);
-    State state = s->GetState();
+    bool contains = current_cover.members >> k & 1;
+    State state = network.sensors[s].GetState();
     if (contains && state != State::kOn)
     {
       satisfied = false;
@@ -206,7 +240,7 @@ bool Sensor::Reshuffle()
   }
   if (satisfied)
   {
-    state_ = current_cover_->Contains(this) ? State::kOn : State::kOff;
+    state_ = contains_self ? State::kOn : State::kOff;
     return true;
   }
   if (next_index)
@@ -214,4 +248,51 @@ bool Sensor::Reshuffle()
     ++current_cover_idx_;
   }
   return false;
-}
\ No newline at end of file
+}
+
+void Sensor::PruneCovers(uint32_t idx, uint32_t dead, uint16_t edge_weight, const NetworkView &network)
+{
+  if (dead == idx)
+  {
+    live_cover_num_ = 0;
+    return;
+  }
+  const CoverStorage &storage = *network.storage;
+  std::span<const uint32_t> local_sensors = storage.LocalSensors(idx);
+  auto it = std::ranges::find(local_sensors, dead);
+  if (it == local_sensors.end())
+  {
+    return;
+  }
+  bit_vec dead_bit = bit_vec{1} << (it - local_sensors.begin());
+  if (dead_members_ & dead_bit)
+  {
+    return;
+  }
+  std::span<Cover> covers = network.CoversOf(idx);
+  auto live_end = std::partition(covers.begin(), covers.end(), [&](const Cover &cover) { return !(cover.members & dead_bit); });
+  std::span<Cover> live(covers.begin(), live_end);
+  if (live.size() != covers.size())
+  {
+    // an edge stands for the members two covers share; drop the weight of edges to newly pruned covers,
+    // those pruned earlier were dropped then
+    const Cover *initial = storage.GetInitialCovers().data() + storage.CoverBegin(idx);
+    for (Cover &cover : live)
+    {
+      uint16_t degree = cover.GetDegree();
+      for (const Edge &edge : storage.Edges(cover.storage_idx))
+      {
+        bit_vec members = initial[edge.first].members;
+        if ((members & dead_bit) && !(members & dead_members_))
+        {
+          degree -= edge_weight; // wraps back like the sum of the weights did
+        }
+      }
+      cover.SetDegree(degree);
+    }
+    std::sort(live.begin(), live.end());
+    current_cover_idx_ = 0;
+  }
+  live_cover_num_ = live.size();
+  dead_members_ |= dead_bit;
+}
@@ -13,45 +13,201 @@
 //   std::cout << "[" << battery_str << "] " << static_cast<int>(percentage) << "%" << std::endl;
 // };
 
-void Simulation::Initialize(const SimulationParameters &parameters, const SimulationScenario &scenario)
+void Simulation::Initialize(const SimulationParameters &parameters, ScenarioView scenario, SpatialOrdering ordering, TaskControl *control)
 {
   initial_battery_lvl_ = parameters.initial_battery_lvl;
   reshuffle_interval_ = parameters.reshuffle_interval;
-  Sensor::SetRadius(parameters.sensor_radius);
+  context_.SetSensorRadius(parameters.sensor_radius);
+  if (scenario.sensor_positions.size() > size_t{Cover::kMaxMinId} + 1)
+  {
+    throw std::runtime_error(std::format("more than {} sensors", size_t{Cover::kMaxMinId} + 1));
+  }
   PlaceAtPositions(scenario.target_positions, scenario.sensor_positions);
+  RenumberAlongCurve(ordering);
 
-  std::vector<size_t> sensors_idx;
-  std::vector<size_t> target_idx;
-  SortByPositions(target_idx, sensors_idx);
-  DetermineNeighborhoods(target_idx, sensors_idx);
+  CsrGraph sensor_targets;
+  CsrGraph sensor_sensors;
+  {
+    std::pmr::vector<size_t> sensors_idx(context_.GetScratch());
+    std::pmr::vector<size_t> target_idx(context_.GetScratch());
+    SortByPositions(target_idx, sensors_idx);
+    DetermineNeighborhoods(target_idx, sensors_idx, sensor_targets, sensor_sensors);
+  }
+  context_.ReleaseScratch();
+  if (control)
+  {
+    control->ThrowIfCancelled();
+  }
+  auto storage = std::make_shared<CoverStorage>(std::move(sensor_targets), std::move(sensor_sensors));
+  InitializeSensors(*storage, control);
+  covers_ = storage->GetInitialCovers();
+  for (uint32_t i = 0; i < sensor_num; ++i)
+  {
+    sensors_[i].ResetRuntime(sensors_[i].GetBatteryLevel(), !storage->LocalTargets(i).empty(), storage->CoverEnd(i) - storage->CoverBegin(i));
+  }
+  storage_ = std::move(storage);
+}
+
+Simulation Simulation::Clone() const
+{
+  return Simulation(*this);
+}
 
-  for (auto &sensor : sensors_)
+Simulation Simulation::Fork(const SimulationParameters &parameters) const
+{
+  if (parameters.sensor_radius != context_.GetSensorRadius())
   {
-    sensor.Initialize();
+    throw std::runtime_error("A forked simulation must keep the sensor radius, covers depend on it");
   }
+  Simulation fork = Clone();
+  fork.initial_battery_lvl_ = parameters.initial_battery_lvl;
+  fork.reshuffle_interval_ = parameters.reshuffle_interval;
+  fork.tick_ = -1;
+  fork.covered_targets_count_ = 0;
+  fork.all_target_covered_ = false;
+  fork.depleted_sensor_count_ = 0;
+  for (auto &target : fork.targets_)
+  {
+    target.SetCoverFlag(false);
+  }
+  for (uint32_t i = 0; i < sensor_num; ++i)
+  {
+    fork.sensors_[i].ResetRuntime(fork.initial_battery_lvl_, !storage_->LocalTargets(i).empty(), storage_->CoverEnd(i) - storage_->CoverBegin(i));
+  }
+  // all members start with the same battery, so every LDGraph edge weighs initial_battery_lvl_
+  // and these are the values LDGraphGenerator computes
+  const auto &initial_covers = storage_->GetInitialCovers();
+  for (size_t c = 0; c < initial_covers.size(); ++c)
+  {
+    const Cover &initial = initial_covers[c];
+    uint16_t degree = static_cast<uint16_t>(storage_->Edges(c).size() * fork.initial_battery_lvl_); // wraps like the sum of the weights
+    fork.covers_[c] = Cover(initial.storage_idx, initial.members, false, degree, fork.initial_battery_lvl_, std::popcount(initial.members), initial.GetMinId());
+  }
+  return fork;
+}
+
+SimulationLayout Simulation::GetLayout() const
+{
+  return SimulationLayout{context_.GetSensorRadius(), target_input_idx_, sensor_input_idx_, storage_};
+}
+
+SimulationSnapshot Simulation::TakeSnapshot() const
+{
+  SimulationSnapshot snapshot;
+  snapshot.initial_battery_lvl = initial_battery_lvl_;
+  snapshot.reshuffle_interval = reshuffle_interval_;
+  snapshot.tick = tick_;
+  snapshot.battery_lvls.reserve(sensor_num);
+  snapshot.states.reserve(sensor_num);
+  snapshot.cover_indices.reserve(sensor_num);
+  for (const auto &sensor : sensors_)
+  {
+    snapshot.battery_lvls.emplace_back(sensor.GetBatteryLevel());
+    snapshot.states.emplace_back(sensor.GetState());
+    snapshot.cover_indices.emplace_back(sensor.GetCoverIndex());
+  }
+  snapshot.target_flags.reserve(target_num);
+  for (const auto &target : targets_)
+  {
+    snapshot.target_flags.emplace_back(target.GetCoverFlag());
+  }
+  snapshot.covers = covers_;
+  return snapshot;
+}
+
+Simulation Simulation::Restore(ScenarioView scenario, SimulationLayout layout, const SimulationSnapshot &snapshot)
+{
+  size_t target_num = scenario.target_positions.size();
+  size_t sensor_num = scenario.sensor_positions.size();
+  if (!layout.storage || layout.target_input_idx.size() != target_num || layout.sensor_input_idx.size() != sensor_num ||
+      layout.storage->GetSensorNum() != sensor_num)
+  {
+    throw std::runtime_error("Simulation layout does not match the scenario");
+  }
+  auto is_permutation = [](const std::vector<size_t> &input_idx)
+  {
+    std::vector<bool> seen(input_idx.size());
+    for (size_t idx : input_idx)
+    {
+      if (idx >= seen.size() || seen[idx])
+      {
+        return false;
+      }
+      seen[idx] = true;
+    }
+    return true;
+  };
+  if (!is_permutation(layout.target_input_idx) || !is_permutation(layout.sensor_input_idx))
+  {
+    throw std::runtime_error("Simulation layout does not match the scenario");
+  }
+  if (snapshot.battery_lvls.size() != sensor_num || snapshot.states.size() != sensor_num ||
+      snapshot.cover_indices.size() != sensor_num || snapshot.target_flags.size() != target_num ||
+      snapshot.covers.size() != layout.storage->GetCoverNum() || snapshot.reshuffle_interval == 0)
+  {
+    throw std::runtime_error("Simulation snapshot does not match the layout");
+  }
+  Simulation simulation;
+  simulation.initial_battery_lvl_ = snapshot.initial_battery_lvl;
+  simulation.reshuffle_interval_ = snapshot.reshuffle_interval;
+  simulation.context_.SetSensorRadius(layout.sensor_radius);
+  simulation.PlaceAtPositions(scenario.target_positions, scenario.sensor_positions); // ids follow the scenario, as in Initialize
+  simulation.target_input_idx_ = std::move(layout.target_input_idx);
+  simulation.sensor_input_idx_ = std::move(layout.sensor_input_idx);
+  ApplyOrder(simulation.targets_, simulation.target_input_idx_);
+  ApplyOrder(simulation.sensors_, simulation.sensor_input_idx_);
+  simulation.storage_ = std::move(layout.storage);
+  simulation.tick_ = snapshot.tick;
+  for (size_t i = 0; i < sensor_num; ++i)
+  {
+    simulation.sensors_[i].RestoreRuntime(snapshot.battery_lvls[i], snapshot.states[i], snapshot.cover_indices[i]);
+    if (snapshot.battery_lvls[i] == 0) // batteries start at the reshuffle interval or above, so only depleted ones are empty
+    {
+      ++simulation.depleted_sensor_count_;
+    }
+  }
+  for (size_t i = 0; i < target_num; ++i)
+  {
+    simulation.targets_[i].SetCoverFlag(snapshot.target_flags[i]);
+  }
+  simulation.covers_ = snapshot.covers;
+  NetworkView network = simulation.View();
+  for (uint32_t i = 0; i < sensor_num; ++i)
+  {
+    if (!simulation.sensors_[i].RestorePruning(i, network))
+    {
+      throw std::runtime_error("Simulation snapshot does not match the layout");
+    }
+  }
+  return simulation;
 }
 
 SimulationState Simulation::GetSimulationState()
 {
   SimulationState state;
+  FillSimulationState(state);
+  return state;
+}
+
+void Simulation::FillSimulationState(SimulationState &state)
+{
   auto &sensor_states = state.sensor_states;
   auto &sensor_battery_lvls = state.sensor_battery_lvls;
-  sensor_states.reserve(sensor_num);
-  sensor_battery_lvls.reserve(sensor_num);
+  sensor_states.resize(sensor_num);
+  sensor_battery_lvls.resize(sensor_num);
   for (int i = 0; i < sensor_num; ++i)
   {
-    sensor_states.emplace_back(sensors_[i].GetState());
-    sensor_battery_lvls.emplace_back(sensors_[i].GetBatteryLevel());
+    sensor_states[sensor_input_idx_[i]] = sensors_[i].GetState();
+    sensor_battery_lvls[sensor_input_idx_[i]] = sensors_[i].GetBatteryLevel();
   }
   state.tick = tick_;
-  state.is_target_covered = CountCover();
+  CountCover(state.is_target_covered);
   state.all_target_covered = all_target_covered_;
   state.covered_target_count = covered_targets_count_;
   state.coverage_percentage = covered_targets_count_ / (float)target_num;
-  return state;
 }
 
-void Simulation::PlaceAtPositions(const std::vector<Point> &target_positions, const std::vector<Point> &sensor_positions)
+void Simulation::PlaceAtPositions(std::span<const Point> target_positions, std::span<const Point> sensor_positions)
 {
   target_num = target_positions.size();
   sensor_num = sensor_positions.size();
@@ -59,15 +215,50 @@ void Simulation::PlaceAtPositions(const std::vector<Point> &target_positions, co
   sensors_.reserve(sensor_num);
   for (int i = 0; i < target_num; ++i)
   {
-    targets_.emplace_back(target_positions[i]);
+    targets_.emplace_back(target_positions[i], context_.NextTargetId());
   }
   for (int i = 0; i < sensor_num; ++i)
   {
-    sensors_.emplace_back(sensor_positions[i], initial_battery_lvl_);
+    sensors_.emplace_back(sensor_positions[i], initial_battery_lvl_, context_.NextSensorId());
   }
 }
 
-void Simulation::SortByPositions(std::vector<size_t> &targets_idx, std::vector<size_t> &sensors_idx)
+void Simulation::RenumberAlongCurve(SpatialOrdering ordering)
+{
+  target_input_idx_.resize(target_num);
+  sensor_input_idx_.resize(sensor_num);
+  std::iota(target_input_idx_.begin(), target_input_idx_.end(), 0);
+  std::iota(sensor_input_idx_.begin(), sensor_input_idx_.end(), 0);
+  if (ordering == SpatialOrdering::kInput)
+  {
+    return;
+  }
+  auto reorder = [this, ordering](auto &entities, std::vector<size_t> &input_idx)
+  {
+    std::pmr::vector<Point> positions(context_.GetScratch());
+    positions.reserve(entities.size());
+    for (const auto &entity : entities)
+    {
+      positions.emplace_back(entity.GetPosition());
+    }
+    CurveGrid grid(positions.begin(), positions.end());
+    std::pmr::vector<uint32_t> keys(context_.GetScratch());
+    keys.reserve(entities.size());
+    for (const Point &p : positions)
+    {
+      auto [x, y] = grid.Cell(p);
+      keys.emplace_back(ordering == SpatialOrdering::kHilbert ? HilbertKey(x, y) : MortonKey(x, y));
+    }
+    std::stable_sort(input_idx.begin(), input_idx.end(), [&](size_t i1, size_t i2)
+                     { return keys[i1] < keys[i2]; });
+    ApplyOrder(entities, input_idx);
+  };
+  reorder(targets_, target_input_idx_);
+  reorder(sensors_, sensor_input_idx_);
+  context_.ReleaseScratch();
+}
+
+void Simulation::SortByPositions(std::pmr::vector<size_t> &targets_idx, std::pmr::vector<size_t> &sensors_idx)
 {
   targets_idx.resize(target_num);
   sensors_idx.resize(sensor_num);
@@ -89,43 +280,120 @@ void Simulation::SortByPositions(std::vector<size_t> &targets_idx, std::vector<s
   std::sort(sensors_idx.begin(), sensors_idx.end(), sensor_compare);
 }
 
-void Simulation::DetermineNeighborhoods(std::vector<size_t> &targets_idx, std::vector<size_t> &sensors_idx)
+void Simulation::DetermineNeighborhoods(std::pmr::vector<size_t> &targets_idx, std::pmr::vector<size_t> &sensors_idx, CsrGraph &sensor_targets, CsrGraph &sensor_sensors)
 {
-  double R = Sensor::GetRadius();
-  for (size_t idx_t : targets_idx)
+  double R = context_.GetSensorRadius();
+  std::pmr::vector<Point> sensor_positions(context_.GetScratch());
+  sensor_positions.reserve(sensor_num);
+  for (const auto &sensor : sensors_)
   {
-    const Point &t_pos = targets_[idx_t].GetPosition();
-    for (size_t idx_s : sensors_idx)
-    {
-      const Point &s_pos = sensors_[idx_s].GetPosition();
-      if (s_pos.x >= t_pos.x + R)
-        break;
-
-      if (Sqr(s_pos.x - t_pos.x) + Sqr(s_pos.y - t_pos.y) < Sqr(R))
-      {
-        sensors_[idx_s].AddLocalTarget(targets_[idx_t]);
-      }
-    }
+    sensor_positions.emplace_back(sensor.GetPosition());
   }
-  for (size_t idx1 = 0; idx1 < sensors_idx.size(); ++idx1)
-  {
-    size_t i = sensors_idx[idx1];
-    const Point &pos_i = sensors_[i].GetPosition();
+  SpatialGrid grid(sensor_positions, R);
 
-    for (size_t idx2 = idx1 + 1; idx2 < sensors_idx.size(); ++idx2)
-    {
-      size_t j = sensors_idx[idx2];
-      const Point &pos_j = sensors_[j].GetPosition();
+  // targets are visited in sorted order and chunks are merged in order,
+  // so every sensor receives its local targets sorted by position
+  std::vector<CsrGraph::EdgeList> target_edges(ChunkCount(target_num));
+  ParallelChunks(target_num, target_edges.size(), [&](size_t chunk, size_t begin, size_t end)
+                 {
+                   auto &edges = target_edges[chunk];
+                   for (size_t k = begin; k < end; ++k)
+                   {
+                     uint32_t idx_t = targets_idx[k];
+                     grid.ForEachInRadius(targets_[idx_t].GetPosition(), [&](uint32_t idx_s)
+                                          { edges.emplace_back(idx_s, idx_t); });
+                   } });
+  sensor_targets = CsrGraph::FromEdgeLists(sensor_num, target_edges);
+  target_edges.clear();
 
-      if (pos_j.x >= pos_i.x + R)
-        break;
+  // local sensors are sorted by position as well, which keeps the order of generated covers independent of the grid layout
+  std::pmr::vector<size_t> sensor_rank(sensor_num, context_.GetScratch());
+  for (size_t rank = 0; rank < sensor_num; ++rank)
+  {
+    sensor_rank[sensors_idx[rank]] = rank;
+  }
+  std::vector<CsrGraph::EdgeList> sensor_edges(ChunkCount(sensor_num));
+  ParallelChunks(sensor_num, sensor_edges.size(), [&](size_t chunk, size_t begin, size_t end)
+                 {
+                   auto &edges = sensor_edges[chunk];
+                   for (size_t i = begin; i < end; ++i)
+                   {
+                     size_t first = edges.size();
+                     grid.ForEachInRadius(sensors_[i].GetPosition(), [&](uint32_t j)
+                                          {
+                                            if (j != i)
+                                            {
+                                              edges.emplace_back(i, j);
+                                            } });
+                     std::sort(edges.begin() + first, edges.end(), [&](const auto &e1, const auto &e2)
+                               { return sensor_rank[e1.second] < sensor_rank[e2.second]; });
+                   } });
+  sensor_sensors = CsrGraph::FromEdgeLists(sensor_num, sensor_edges);
+  sensor_edges.clear();
+}
 
-      if (Sqr(pos_i.x - pos_j.x) + Sqr(pos_i.y - pos_j.y) < Sqr(R))
-      {
-        sensors_[i].AddLocalSensor(sensors_[j]);
-        sensors_[j].AddLocalSensor(sensors_[i]);
-      }
-    }
+void Simulation::InitializeSensors(CoverStorage &storage, TaskControl *control)
+{
+  NetworkView network{sensors_, targets_, {}, &storage};
+  size_t chunk_num = ChunkCount(sensor_num, 256);
+  std::vector<LocalCovers> batches(chunk_num); // covers of each chunk of sensors, in sensor order
+  std::atomic<size_t> initialized = 0;         // a single sensor may take long to enumerate, so progress is counted per sensor
+  ParallelChunks(sensor_num, chunk_num, [&](size_t chunk, size_t begin, size_t end)
+                 {
+                   // local_bit[t] is the position of target t among the local targets of the current sensor, or -1
+                   std::vector<int8_t> local_bit(target_num, -1);
+                   std::vector<bit_vec> masks;
+                   // temporaries of cover generation are returned to the pool after every sensor and reused by the next one,
+                   // the pool itself is released at once when the chunk is done
+                   std::pmr::unsynchronized_pool_resource scratch;
+                   LocalCovers &batch = batches[chunk];
+                   for (size_t i = begin; i < end; ++i)
+                   {
+                     if (control)
+                     {
+                       control->ThrowIfCancelled();
+                       control->SetProgress(static_cast<float>(initialized.fetch_add(1)) / sensor_num);
+                     }
+                     std::span<const uint32_t> local_targets = storage.LocalTargets(i);
+                     std::span<const uint32_t> local_sensors = storage.LocalSensors(i);
+                     masks.clear();
+                     if (local_targets.empty() || local_targets.size() > bit_vec_size || local_sensors.size() > bit_vec_size)
+                     {
+                       sensors_[i].Initialize(i, network, masks, batch, &scratch); // reports the sensor as dead or throws
+                       continue;
+                     }
+                     for (size_t k = 0; k < local_targets.size(); ++k)
+                     {
+                       local_bit[local_targets[k]] = static_cast<int8_t>(k);
+                     }
+                     auto cover_mask = [&](size_t j) -> bit_vec
+                     {
+                       bit_vec mask = 0;
+                       for (uint32_t t : storage.LocalTargets(j))
+                       {
+                         if (local_bit[t] >= 0)
+                         {
+                           mask |= bit_vec{1} << local_bit[t];
+                         }
+                       }
+                       return mask;
+                     };
+                     for (uint32_t j : local_sensors)
+                     {
+                       masks.emplace_back(cover_mask(j));
+                     }
+                     masks.emplace_back(cover_mask(i));
+                     for (uint32_t t : local_targets)
+                     {
+                       local_bit[t] = -1;
+                     }
+                     sensors_[i].Initialize(i, network, masks, batch, &scratch);
+                   } });
+  // covers of a sensor are stored contiguously, in sensor order
+  storage.AppendCovers(batches);
+  if (control)
+  {
+    control->SetProgress(1.0f);
   }
 }
 
@@ -144,14 +412,15 @@ void Simulation::Tick()
       sensor.BeginReshuffle();
     }
   }
+  NetworkView network = View();
   uint32_t counter = 0;
   while (reshuffle_active && counter != 0xfff)
   {
     ++counter;
     reshuffle_active = false;
-    for (auto &sensor : sensors_)
+    for (uint32_t i = 0; i < sensor_num; ++i)
     {
-      if (!sensor.Reshuffle())
+      if (!sensors_[i].Reshuffle(i, network))
       {
         reshuffle_active = true;
       }
@@ -167,21 +436,46 @@ void Simulation::Tick()
       }
     }
   }
-  for (auto &sensor : sensors_)
+  for (uint32_t i = 0; i < sensor_num; ++i)
   {
-    sensor.Update();
+    if (sensors_[i].Update(i, network))
+    {
+      ++depleted_sensor_count_;
+      PruneDeadCovers(i);
+    }
   }
 }
 
-std::vector<bool> Simulation::CountCover()
+void Simulation::PruneDeadCovers(uint32_t dead)
+{
+  NetworkView network = View();
+  sensors_[dead].PruneCovers(dead, dead, initial_battery_lvl_, network);
+  for (uint32_t s : storage_->LocalSensors(dead))
+  {
+    sensors_[s].PruneCovers(s, dead, initial_battery_lvl_, network);
+  }
+}
+
+uint32_t Simulation::CountCoveredTargets()
+{
+  covered_targets_count_ = 0;
+  for (const auto &target : targets_)
+  {
+    covered_targets_count_ += target.GetCoverFlag();
+  }
+  all_target_covered_ = covered_targets_count_ == targets_.size();
+  return covered_targets_count_;
+}
+
+void Simulation::CountCover(std::vector<bool> &is_target_covered)
 {
-  std::vector<bool> is_target_covered(target_num);
+  is_target_covered.resize(target_num);
   covered_targets_count_ = 0;
   for (int i = 0; i < target_num; ++i)
   {
     auto &target = targets_[i];
-    is_target_covered[i] = target.GetCoverFlag();
-    if (is_target_covered[i])
+    is_target_covered[target_input_idx_[i]] = target.GetCoverFlag();
+    if (target.GetCoverFlag())
     {
       ++covered_targets_count_;
     }
@@ -195,5 +489,4 @@ std::vector<bool> Simulation::CountCover()
   //   DrawBattery(targets_.size(), covered_targets_count_);
   // }
   all_target_covered_ = covered_targets_count_ == targets_.size();
-  return is_target_covered;
 }
\ No newline at end of file
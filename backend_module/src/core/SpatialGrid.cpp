@@ -0,0 +1,61 @@
+#include "core/SpatialGrid.hpp"
+
+SpatialGrid::SpatialGrid(std::span<const Point> points, double radius)
+    : min_(0.0, 0.0),
+      radius_(radius),
+      cell_size_(radius),
+      nx_(1),
+      ny_(1)
+{
+  Point max(0.0, 0.0);
+  if (!points.empty())
+  {
+    min_ = max = points.front();
+  }
+  for (const Point &p : points)
+  {
+    min_.x = std::min(min_.x, p.x);
+    min_.y = std::min(min_.y, p.y);
+    max.x = std::max(max.x, p.x);
+    max.y = std::max(max.y, p.y);
+  }
+  if (!(cell_size_ > 0.0))
+  {
+    cell_size_ = 1.0;
+  }
+  // a large field with a tiny radius would produce mostly empty cells, so their number is kept proportional to the input
+  const double max_cells = 4.0 * points.size() + 16.0;
+  auto cells_along = [&](double extent)
+  { return std::floor(extent / cell_size_) + 1.0; };
+  while (cells_along(max.x - min_.x) * cells_along(max.y - min_.y) > max_cells)
+  {
+    cell_size_ *= 2.0;
+  }
+  nx_ = static_cast<int64_t>(cells_along(max.x - min_.x));
+  ny_ = static_cast<int64_t>(cells_along(max.y - min_.y));
+
+  std::vector<uint32_t> cell_of(points.size());
+  cell_start_.assign(nx_ * ny_ + 1, 0);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    int64_t cx = std::min(CellCoord(points[i].x - min_.x), nx_ - 1);
+    int64_t cy = std::min(CellCoord(points[i].y - min_.y), ny_ - 1);
+    cell_of[i] = static_cast<uint32_t>(cy * nx_ + cx);
+    ++cell_start_[cell_of[i] + 1];
+  }
+  for (size_t c = 1; c < cell_start_.size(); ++c)
+  {
+    cell_start_[c] += cell_start_[c - 1];
+  }
+  items_.resize(points.size());
+  xs_.resize(points.size());
+  ys_.resize(points.size());
+  std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    uint32_t k = fill[cell_of[i]]++;
+    items_[k] = static_cast<uint32_t>(i);
+    xs_[k] = points[i].x;
+    ys_[k] = points[i].y;
+  }
+}
@@ -0,0 +1,145 @@
+#include "core/ThreadPool.hpp"
+
+#include <utility>
+
+static thread_local ThreadPool *CurrentPool = nullptr; ///< The pool owning the current thread, if it is a worker.
+static thread_local size_t CurrentQueue = 0;           ///< The queue of the current worker.
+
+ThreadPool::ThreadPool(size_t thread_num)
+{
+  if (thread_num == 0)
+  {
+    thread_num = HardwareThreads();
+  }
+  queues_.reserve(thread_num);
+  for (size_t i = 0; i < thread_num; ++i)
+  {
+    queues_.emplace_back(std::make_unique<Queue>());
+  }
+  workers_.reserve(thread_num);
+  for (size_t i = 0; i < thread_num; ++i)
+  {
+    workers_.emplace_back([this, i]()
+                          { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+  size_t idx;
+  if (CurrentPool == this)
+  {
+    idx = CurrentQueue;
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idx = next_queue_;
+    next_queue_ = (next_queue_ + 1) % queues_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues_[idx]->mutex);
+    queues_[idx]->jobs.emplace_back(std::move(job));
+  }
+  {
+    // the job is counted only once it is in a queue, so a worker claiming it always finds one
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++queued_;
+    ++pending_;
+  }
+  wake_.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]()
+             { return pending_ == 0; });
+  if (error_)
+  {
+    std::exception_ptr error = std::exchange(error_, nullptr);
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::WorkerLoop(size_t idx)
+{
+  CurrentPool = this;
+  CurrentQueue = idx;
+  SerialThread = true;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this]()
+                 { return queued_ > 0 || stopping_; });
+      if (queued_ == 0)
+      {
+        return;
+      }
+      --queued_;
+    }
+    std::function<void()> job = Take(idx);
+    std::exception_ptr error;
+    try
+    {
+      job();
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    job = nullptr; // captured state is released before the job counts as finished
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error && !error_)
+    {
+      error_ = error;
+    }
+    if (--pending_ == 0)
+    {
+      idle_.notify_all();
+    }
+  }
+}
+
+std::function<void()> ThreadPool::Take(size_t idx)
+{
+  while (true)
+  {
+    {
+      Queue &own = *queues_[idx];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.jobs.empty())
+      {
+        std::function<void()> job = std::move(own.jobs.back());
+        own.jobs.pop_back();
+        return job;
+      }
+    }
+    for (size_t k = 1; k < queues_.size(); ++k)
+    {
+      Queue &victim = *queues_[(idx + k) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.jobs.empty())
+      {
+        std::function<void()> job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        return job;
+      }
+    }
+    std::this_thread::yield(); // other workers took the jobs seen by this scan, but as many remain as are claimed
+  }
+}
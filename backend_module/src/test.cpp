@@ -1,22 +1,320 @@
 #include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <filesystem>
+#include <bit>
+#include <cmath>
 // #include <chrono>
 // #include <random>
 
 #include "core/Simulation.hpp"
 #include "api/SimulationManager.hpp"
+#include "api/BatchRunner.hpp"
 // #include "core/minimal_cover.hpp"
 
-int main()
+static std::atomic<size_t> allocation_count{0}; ///< Number of allocations made through any global operator new so far.
+
+/**
+ * @brief Allocates and counts the memory of every replaced global operator new.
+ * @param size The number of bytes.
+ * @param alignment The alignment, or 0 for the default alignment of malloc.
+ * @return The memory, or nullptr if it cannot be allocated.
+ */
+static void *CountedAllocate(std::size_t size, std::size_t alignment) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  size = size == 0 ? 1 : size;
+  if (alignment == 0)
+  {
+    return std::malloc(size);
+  }
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+/**
+ * @brief Frees memory of CountedAllocate, for every replaced global operator delete.
+ * @param ptr The memory, may be nullptr.
+ * @param alignment The alignment it was allocated with.
+ */
+static void CountedFree(void *ptr, [[maybe_unused]] std::size_t alignment) noexcept
+{
+#ifdef _WIN32
+  if (alignment != 0)
+  {
+    _aligned_free(ptr);
+    return;
+  }
+#endif
+  std::free(ptr);
+}
+
+/**
+ * @brief Allocates memory for the throwing forms of operator new.
+ * @param size The number of bytes.
+ * @param alignment The alignment, or 0 for the default alignment of malloc.
+ * @return The memory.
+ * @exception Throws std::bad_alloc if the memory cannot be allocated.
+ */
+static void *CountedNew(std::size_t size, std::size_t alignment)
+{
+  if (void *ptr = CountedAllocate(size, alignment))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// every form is replaced, so each delete frees what the matching new allocated
+void *operator new(std::size_t size) { return CountedNew(size, 0); }
+void *operator new[](std::size_t size) { return CountedNew(size, 0); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return CountedNew(size, static_cast<std::size_t>(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return CountedNew(size, static_cast<std::size_t>(alignment)); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return CountedAllocate(size, 0); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return CountedAllocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return CountedAllocate(size, static_cast<std::size_t>(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return CountedAllocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void *ptr) noexcept { CountedFree(ptr, 0); }
+void operator delete[](void *ptr) noexcept { CountedFree(ptr, 0); }
+void operator delete(void *ptr, std::size_t) noexcept { CountedFree(ptr, 0); }
+void operator delete[](void *ptr, std::size_t) noexcept { CountedFree(ptr, 0); }
+void operator delete(void *ptr, std::align_val_t alignment) noexcept { CountedFree(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept { CountedFree(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete(void *ptr, std::size_t, std::align_val_t alignment) noexcept { CountedFree(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t alignment) noexcept { CountedFree(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { CountedFree(ptr, 0); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { CountedFree(ptr, 0); }
+void operator delete(void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept { CountedFree(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete[](void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept { CountedFree(ptr, static_cast<std::size_t>(alignment)); }
+
+/**
+ * @brief Runs a configuration and counts heap allocations made during each tick.
+ * @details Ticks of the first reshuffle interval are a warm-up, in which the buffers of the reused state grow
+ * to their final size. Every later tick, including the state passed to the sink, must not allocate.
+ * @param config_path The path to the configuration file.
+ * @return The number of ticks after the warm-up that allocated.
+ */
+static uint32_t CountAllocatingTicks(const std::string &config_path)
 {
   SimulationManager m;
-  m.LoadParametersFromJSON("config2.json");
-  m.LoadScenarioFromJSON("config2.json");
+  m.LoadConfigFromJSON(config_path);
   m.Initialize();
+  uint32_t warm_up = m.GetParameters().reshuffle_interval;
+  uint32_t allocating_ticks = 0;
+  size_t last_count = 0;
+  m.SetStateSink(std::make_shared<CallbackStateSink>([&](const SimulationState &state)
+                                                     {
+    size_t count = allocation_count.load(std::memory_order_relaxed);
+    if (state.tick >= warm_up && count != last_count)
+    {
+      ++allocating_ticks;
+    }
+    last_count = count; }));
   m.Run();
-  auto states = m.GetSimulationStates();
-  std::cout << "Lifetime: " << states.back().tick << '\n';
-  std::cout << "Sensors: " << states.back().sensor_states.size() << '\n';
+  return allocating_ticks;
+}
+
+/**
+ * @brief Runs a small batch of generated scenarios and checks every field of its statistics.
+ * @return true if the statistics are consistent.
+ */
+static bool CheckBatchStatistics()
+{
+  BatchSpec spec;
+  spec.parameters = SimulationParameters(0.3, 50, 5, SimulationStopCondition::kZeroCoverage, 0.0f, 1000);
+  spec.target_num = 10;
+  spec.sensor_num = 20;
+  spec.generator.neighborhood_radius = spec.parameters.sensor_radius;
+  spec.run_num = 4;
+  spec.thread_num = 2;
+  BatchStatistics statistics = BatchRunner(spec).Run();
+  std::cout << "Batch: " << statistics.run_num << " runs, " << statistics.failed_run_num << " failed, lifetime "
+            << statistics.lifetime_min << " .. " << statistics.lifetime_max << ", mean " << statistics.lifetime_mean
+            << ", stddev " << statistics.lifetime_stddev << ", percentiles";
+  for (uint32_t lifetime : statistics.lifetime_percentiles)
+  {
+    std::cout << ' ' << lifetime;
+  }
+  std::cout << ", " << statistics.coverage_mean.size() << " ticks of coverage\n";
+  if (statistics.run_num + statistics.failed_run_num != spec.run_num || statistics.run_num == 0 ||
+      statistics.lifetime_min > statistics.lifetime_mean || statistics.lifetime_mean > statistics.lifetime_max ||
+      statistics.lifetime_stddev < 0.0 || statistics.lifetime_percentiles.size() != spec.percentiles.size() ||
+      statistics.coverage_mean.empty() || statistics.coverage_percentiles.size() != spec.percentiles.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < spec.percentiles.size(); ++i)
+  {
+    uint32_t lifetime = statistics.lifetime_percentiles[i];
+    if (lifetime < statistics.lifetime_min || lifetime > statistics.lifetime_max ||
+        (i > 0 && lifetime < statistics.lifetime_percentiles[i - 1]) ||
+        statistics.coverage_percentiles[i].size() != statistics.coverage_mean.size())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Runs a configuration into the default history and checks the heap allocations made after the warm-up.
+ * @details Push moves every state into the history, which keeps deltas in four growing arrays (records, state changes,
+ * coverage flips, battery fixes) and copies a full state every keyframe interval. Only growing those arrays and
+ * taking keyframes may allocate, so the count is bounded by the logarithm of the array sizes, not by the number of ticks.
+ * @param config_path The path to the configuration file.
+ * @return true if the allocations stay within the bound.
+ */
+static bool CheckHistoryAllocations(const std::string &config_path)
+{
+  constexpr size_t kKeyframeInterval = 1024; // of the history a SimulationManager records into
+  SimulationManager m;
+  m.LoadConfigFromJSON(config_path);
+  m.Initialize();
+  m.RunFor(m.GetParameters().reshuffle_interval);
+  size_t before = allocation_count.load(std::memory_order_relaxed);
+  m.Run();
+  size_t allocations = allocation_count.load(std::memory_order_relaxed) - before;
+  size_t ticks = m.GetTicksRun();
+  size_t entities = m.GetScenario().sensor_positions.size() + m.GetScenario().target_positions.size();
+  // every array at most doubles to its final size, which is below ticks * entities; a keyframe is three arrays
+  size_t keyframes = ticks / kKeyframeInterval + 1;
+  size_t bound = 4 * (std::bit_width(ticks * (entities + 1)) + 1) + (std::bit_width(keyframes) + 1) + 3 * keyframes;
+  std::cout << "History allocations after warm-up: " << allocations << " in " << ticks << " ticks, bound " << bound << '\n';
+  return allocations <= bound;
+}
+
+/**
+ * @brief Saves a checkpoint of a configuration after its first sensor death and checks that the restored run ends the same.
+ * @details The original run and a fresh manager loaded from the checkpoint both run to the end; every state after the
+ * checkpoint, and so the lifetime, must be equal. The checkpoint and its layout file are written to a temporary directory.
+ * @param config_path The path to the configuration file.
+ * @return true if the restored run matches the original.
+ */
+static bool CheckCheckpointRoundTrip(const std::string &config_path)
+{
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "wsn_cpp_test_checkpoint";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::string path = (dir / "run.ckpt").string();
+
+  SimulationManager original;
+  original.LoadConfigFromJSON(config_path);
+  original.Initialize();
+  SimulationState saved = original.RunUntil([](const SimulationState &state)
+                                            { return std::ranges::find(state.sensor_battery_lvls, 0) != state.sensor_battery_lvls.end(); });
+  original.SaveCheckpoint(path);
+  original.Run();
+  std::vector<SimulationState> expected = original.GetSimulationStates();
+
+  SimulationManager restored;
+  restored.LoadCheckpoint(path);
+  restored.Run();
+  std::vector<SimulationState> actual = restored.GetSimulationStates();
+  std::filesystem::remove_all(dir);
+
+  std::cout << "Checkpoint at tick " << saved.tick << ": lifetime " << expected.back().tick << " vs " << actual.back().tick << '\n';
+  size_t first = saved.tick + 1; // the history of the restored run starts after the checkpoint
+  if (original.GetTicksRun() != restored.GetTicksRun() || expected.size() != first + actual.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < actual.size(); ++i)
+  {
+    const SimulationState &a = expected[first + i];
+    const SimulationState &b = actual[i];
+    if (a.tick != b.tick || a.sensor_states != b.sensor_states || a.sensor_battery_lvls != b.sensor_battery_lvls ||
+        a.is_target_covered != b.is_target_covered || a.covered_target_count != b.covered_target_count)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checkpoints two runs of a configuration whose radii differ by one ulp and restores both.
+ * @details No distance lies between the radii, so both runs have the same neighborhoods and covers. Their layouts
+ * still differ in the radius, so each checkpoint must get its own layout file and restore with its own radius.
+ * @param config_path The path to the configuration file.
+ * @return true if both checkpoints restore and end like their runs.
+ */
+static bool CheckCheckpointRadii(const std::string &config_path)
+{
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "wsn_cpp_test_radii";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  SimulationManager runs[2];
+  runs[0].LoadConfigFromJSON(config_path);
+  runs[1].LoadConfigFromJSON(config_path);
+  SimulationParameters parameters = runs[0].GetParameters();
+  parameters.sensor_radius = std::nextafter(parameters.sensor_radius, 1.0);
+  runs[1].SetParameters(parameters);
+  bool ok = true;
+  for (size_t i = 0; i < 2; ++i)
+  {
+    std::string path = (dir / ("run" + std::to_string(i) + ".ckpt")).string();
+    runs[i].Initialize();
+    runs[i].RunFor(runs[i].GetParameters().reshuffle_interval);
+    runs[i].SaveCheckpoint(path);
+    runs[i].Run();
+    SimulationState expected = runs[i].GetSimulationStates().back();
+
+    SimulationManager restored;
+    restored.LoadCheckpoint(path); // throws if the layout file holds the other radius
+    restored.Run();
+    SimulationState actual = restored.GetSimulationStates().back();
+    ok = ok && restored.GetParameters().sensor_radius == runs[i].GetParameters().sensor_radius && actual.tick == expected.tick &&
+         actual.sensor_states == expected.sensor_states && actual.sensor_battery_lvls == expected.sensor_battery_lvls;
+  }
+  size_t layout_files = std::ranges::count_if(std::filesystem::directory_iterator(dir), [](const auto &entry)
+                                              { return entry.path().extension() == ".wsnlayout"; });
+  std::filesystem::remove_all(dir);
+  std::cout << "Checkpoints of two radii: " << layout_files << " layout files\n";
+  return ok && layout_files == 2;
+}
+
+int main()
+{
+  SimulationManager m;
+  m.LoadConfigFromJSON("config2.json");
+  m.Initialize();
+  RunSummary summary = m.RunSummarized();
+  std::cout << "Lifetime: " << summary.lifetime << '\n';
+  std::cout << "Sensors: " << m.GetScenario().sensor_positions.size() << '\n';
   // m.DumpStatesToJSON("states.json");
+  uint32_t allocating_ticks = CountAllocatingTicks("config2.json");
+  std::cout << "Allocating ticks after warm-up: " << allocating_ticks << '\n';
+  if (allocating_ticks != 0)
+  {
+    std::cerr << "Steady-state ticks must not allocate\n";
+    return 1;
+  }
+  if (!CheckHistoryAllocations("config2.json"))
+  {
+    std::cerr << "Recording into the history must allocate only to grow its arrays\n";
+    return 1;
+  }
+  if (!CheckCheckpointRoundTrip("config2.json"))
+  {
+    std::cerr << "A run restored from a checkpoint must end like the original\n";
+    return 1;
+  }
+  if (!CheckCheckpointRadii("config2.json"))
+  {
+    std::cerr << "Checkpoints of runs with different radii must restore with their own radius\n";
+    return 1;
+  }
+  if (!CheckBatchStatistics())
+  {
+    std::cerr << "Batch statistics are inconsistent\n";
+    return 1;
+  }
   return 0;
 }
 
@@ -116,6 +116,7 @@ class Interface(tk.Tk):
     self.current_idx = 0
     self._job = None
     self.running = False
+    self.init_task = None
 
   def _toggle_auto(self):
     if self.running:
@@ -136,19 +137,30 @@ class Interface(tk.Tk):
       self.after_cancel(self._job)
       self._job = None
 
+  def _advance(self):
+    """Move playback one state forward, computing the next tick on demand. Returns False at the end."""
+    if self.current_idx == len(self.states) - 1:
+      if self.manager.IsFinished():
+        return False
+      self.states.append(self.manager.Step())
+      if self.manager.IsFinished():
+        self.final_state = self.states[-1]
+    self.current_idx += 1
+    self._draw_state(self.states[self.current_idx])
+    return True
+
   def _auto_step(self):
-    if self.current_idx < len(self.states) - 1 and self.running:
-      self.current_idx += 1
-      self._draw_state(self.states[self.current_idx])
+    if self.running and self._advance():
       self._job = self.after(self.delay_var.get(), self._auto_step)
     else:
       self._stop_auto()
 
   def _step_once(self):
     if not self.states: return
-    if self.current_idx < len(self.states) - 1:
-      self.current_idx += 1
-      self._draw_state(self.states[self.current_idx])
+    try:
+      self._advance()
+    except Exception as e:
+      messagebox.showerror("Error", str(e))
   
   def _replay(self):
     """Reset playback to the first state."""
@@ -157,7 +169,7 @@ class Interface(tk.Tk):
     self._stop_auto()
     self.current_idx = 0
     self._draw_state(self.states[0])
-    tick_info = f"Tick: 0 / {len(self.states)-1}"
+    tick_info = f"Tick: 0 / {self._last_tick_info()}"
     if hasattr(self.states[0], 'coverage_percentage') and hasattr(self.states[0], 'covered_target_count'):
         coverage_info = f"  Coverage: {self.states[0].coverage_percentage:.1f}% ({self.states[0].covered_target_count}/{len(self.states[0].is_target_covered)})"
         self.status.config(text=tick_info + coverage_info)
@@ -168,7 +180,7 @@ class Interface(tk.Tk):
     if not self.parameters or not self.scenario:
       messagebox.showwarning("Missing data", "Set both parameters and scenario first.")
       return
-    if self.manager.IsInitialized():
+    if self._is_initialized():
       messagebox.showwarning("Warning", "Reset the simulation first")
       return
     try:
@@ -176,24 +188,37 @@ class Interface(tk.Tk):
       # Initializing the simulation
       self.status.config(text="Initializing simulation...")
       self.config(cursor="watch") 
-      self.update_idletasks()
-      self.manager.Initialize()
-      # Running the simulation
-      self.status.config(text="Running simulation...")
-      self.update_idletasks()
-      self.manager.Run()
+      # Covers are generated on a worker thread, the window stays responsive meanwhile
+      self.init_task = self.manager.InitializeAsync()
+      self._poll_initialization()
+    except Exception as e:
       self.config(cursor="")
-      self.states = list(self.manager.GetSimulationStates())
-      if not self.states:
-        messagebox.showwarning("Warning", "No states generated")
-        return
-      self.final_state = self.states[-1]
+      messagebox.showerror("Error", str(e))
+
+  def _poll_initialization(self):
+    task = self.init_task
+    if task is None: return # cancelled by reset
+    if not task.done():
+      self.status.config(text=f"Initializing simulation... {100 * task.progress():.0f}%")
+      self.after(100, self._poll_initialization)
+      return
+    self.init_task = None
+    self.config(cursor="")
+    try:
+      task.wait()
+      # Further ticks are computed on demand during playback
+      self.states = [self.manager.Step()]
+      self.final_state = self.states[0] if self.manager.IsFinished() else None
       self.current_idx = 0
       self._draw_state(self.states[0])
-      self.status.config(text=f"Tick: 0 / {len(self.states)-1}")
     except Exception as e:
+      self.status.config(text="Initialization failed")
       messagebox.showerror("Error", str(e))
 
+  def _is_initialized(self):
+    """A simulation that is still initializing counts as initialized."""
+    return self.init_task is not None or self.manager.IsInitialized()
+
   def _handle_load(self, choice):
     funcs = {
       "Load both": self._load_both,
@@ -205,23 +230,26 @@ class Interface(tk.Tk):
       func()
 
   def _ask_and_load(self, load_params=False, load_scenario=False):
-    if self.manager.IsInitialized():
+    if self._is_initialized():
       messagebox.showwarning("Warning", "Reset the simulation first")
       return
     path = filedialog.askopenfilename(filetypes=[("JSON files", "*.json")])
     if not path:
       return
     try:
-      if load_params:
+      if load_params and load_scenario:
+        self.manager.LoadConfigFromJSON(path)
+        self.parameters = self.manager.GetParameters()
+        self.scenario = self.manager.GetScenario()
+        self.status.config(text="Parameters and scenario loaded")
+      elif load_params:
         self.manager.LoadParametersFromJSON(path)
         self.parameters = self.manager.GetParameters()
         self.status.config(text="Parameters loaded")
-      if load_scenario:
+      elif load_scenario:
         self.manager.LoadScenarioFromJSON(path)
         self.scenario = self.manager.GetScenario()
         self.status.config(text="Scenario loaded")
-      if load_params and load_scenario:
-        self.status.config(text="Parameters and scenario loaded")
     except Exception as e:
       messagebox.showerror("Error", str(e))
 
@@ -253,7 +281,7 @@ class Interface(tk.Tk):
 
 
   def _set_parameters(self):
-    if self.manager.IsInitialized():
+    if self._is_initialized():
       messagebox.showwarning("Warning", "Reset the simulation first")
       return
     win = self._create_popup("Set Parameters")
@@ -306,7 +334,7 @@ class Interface(tk.Tk):
     tk.Button(win, text="Apply", command=apply).grid(row=len(fields)+1, columnspan=2, pady=5)
 
   def _set_scenario(self):
-    if self.manager.IsInitialized():
+    if self._is_initialized():
       messagebox.showwarning("Warning", "Reset the simulation first")
       return
     win = self._create_popup("Set Scenario")
@@ -340,12 +368,17 @@ class Interface(tk.Tk):
     tk.Button(win, text="Apply", command=apply).grid(row=2, columnspan=2, pady=5)
  
   def _save_report(self):
-    if not self.manager.IsInitialized():
+    if not self._is_initialized():
       messagebox.showwarning("Warning", "No simulation to save")
       return
     if not self.final_state:
-      messagebox.showwarning("Warning", "No simulation data to save")
-      return
+      if not self.states:
+        messagebox.showwarning("Warning", "No simulation data to save")
+        return
+      # Finish the remaining ticks, the report describes the final state
+      self.manager.Run()
+      self.states = list(self.manager.GetSimulationStates())
+      self.final_state = self.states[-1]
     path = filedialog.asksaveasfilename(defaultextension=".txt",
                                       filetypes=[("Text file", "*.txt")])
     if not path: return
@@ -374,10 +407,18 @@ class Interface(tk.Tk):
       messagebox.showerror("Error", str(e))
 
   def _reset(self):
-    if not self.manager.IsInitialized():
+    if not self._is_initialized():
       messagebox.showwarning("Warning", "No simulation to reset")
       return
     self._stop_auto()
+    if self.init_task is not None:
+      self.init_task.cancel()
+      try:
+        self.init_task.wait()
+      except Exception:
+        pass # cancelled
+      self.init_task = None
+      self.config(cursor="")
     self.manager.Reset()
     self.parameters = None
     self.scenario = None
@@ -441,10 +482,14 @@ class Interface(tk.Tk):
     self.tk_img = ImageTk.PhotoImage(img.convert("RGB"))
     self.canvas.create_image(0, 0, anchor="nw", image=self.tk_img)
 
-    tick_info = f"Tick: {state.tick} / {len(self.states)-1}"
+    tick_info = f"Tick: {state.tick} / {self._last_tick_info()}"
     coverage_info = f"  Coverage: { 100 * state.coverage_percentage:.1f}% ({state.covered_target_count}/{len(state.is_target_covered)})"
     self.status.config(text=tick_info + coverage_info)
 
+  def _last_tick_info(self):
+    """Index of the last state, or '?' while later ticks are not computed yet."""
+    return len(self.states) - 1 if self.manager.IsFinished() else "?"
+
   def run(self):
     self.mainloop()
 